@@ -0,0 +1,65 @@
+#ifndef SIM_ARGS_H
+#define SIM_ARGS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Harness options passed as plusargs on the command line, e.g.
+//
+//     obj_dir/Vmultiplier_top +shards=8 +seed=3
+//
+// Verilator only looks at the +verilator+ plusargs and the ones the model
+// asks for with $test$plusargs, so the harness is free to use the rest.
+// If an option is given more than once, the last one wins.
+class SimArgs {
+  public:
+    SimArgs(int argc, char **argv)
+        : argc_{argc}
+        , argv_{argv} {}
+
+    // True for both +name and +name=value
+    bool flag(const char *name) const {
+        return find(name) != nullptr;
+    }
+
+    const char *str(const char *name, const char *default_value) const {
+        const char *value = find(name);
+        if ((value == nullptr) || (*value != '=')) {
+            return default_value;
+        }
+        return value + 1;
+    }
+
+    uint64_t u64(const char *name, uint64_t default_value) const {
+        const char *value = str(name, nullptr);
+        if (value == nullptr) {
+            return default_value;
+        }
+        return std::strtoull(value, nullptr, 0);
+    }
+
+  private:
+    // Returns what follows +name in the last matching argument, which is
+    // either "" or "=value"
+    const char *find(const char *name) const {
+        size_t name_len = std::strlen(name);
+        const char *found = nullptr;
+        for (int i = 1; i < argc_; i++) {
+            const char *arg = argv_[i];
+            if ((arg[0] != '+') || (std::strncmp(arg + 1, name, name_len) != 0)) {
+                continue;
+            }
+            const char *rest = arg + 1 + name_len;
+            if ((*rest == '\0') || (*rest == '=')) {
+                found = rest;
+            }
+        }
+        return found;
+    }
+
+    int argc_;
+    char **argv_;
+};
+
+#endif
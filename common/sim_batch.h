@@ -0,0 +1,105 @@
+#ifndef SIM_BATCH_H
+#define SIM_BATCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Deferred checking.
+//
+// Instead of comparing every output as it comes out, the harness records what
+// it sampled with record() and carries on. The samples go into one array per
+// field, so once the run is over the harness can fill in the reference values
+// with a plain loop over its own arrays of inputs, and check() compares the
+// lot in one pass with no branches, which the compiler vectorizes.
+//
+// Nothing is printed while the run goes, so the flight recorder doesn't get
+// triggered either; rerun without deferred checking to get a dump.
+class BatchCheck {
+  public:
+    explicit BatchCheck(size_t capacity) {
+        time_.reserve(capacity);
+        valid_.reserve(capacity);
+        data_.reserve(capacity);
+        expected_.reserve(capacity);
+    }
+
+    void record(uint64_t time, bool valid, uint64_t data) {
+        time_.push_back(time);
+        valid_.push_back(valid);
+        data_.push_back(data);
+    }
+
+    size_t size() const { return data_.size(); }
+
+    // Where the harness puts the reference values, one per sample
+    uint64_t *expected() {
+        expected_.resize(data_.size());
+        return expected_.data();
+    }
+
+    // Returns the number of samples that weren't valid or didn't match
+    uint64_t check() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        size_t num_samples = data_.size();
+        const uint8_t *valid = valid_.data();
+        const uint64_t *data = data_.data();
+        const uint64_t *reference = expected();
+        uint64_t mismatches = 0;
+        for (size_t i = 0; i < num_samples; i++) {
+            mismatches += (uint64_t)((valid[i] == 0) | (data[i] != reference[i]));
+        }
+        mismatches_ = mismatches;
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        check_seconds_ = elapsed.count();
+        return mismatches;
+    }
+
+    // Prints the first max_reported mismatches found by check() and a summary.
+    // note(i), if given, prints what the harness knows about sample i, e.g.
+    // the inputs
+    void report(const char *what, uint64_t max_reported,
+                const std::function<void(size_t i)> &note = nullptr) const {
+        uint64_t reported = 0;
+        for (size_t i = 0; (i < data_.size()) && (reported < mismatches_); i++) {
+            if (valid_[i] && (data_[i] == expected_[i])) {
+                continue;
+            }
+            if (reported == max_reported) {
+                VL_PRINTF("... and %" VL_PRI64 "u more\n", mismatches_ - reported);
+                break;
+            }
+            reported++;
+            if (!valid_[i]) {
+                VL_PRINTF("[%" VL_PRI64 "d] ERROR: %s not valid\n", time_[i], what);
+            }
+            else {
+                VL_PRINTF("[%" VL_PRI64 "d] ERROR: %s wrong. Expected: %" VL_PRI64 "x, \
+Actual: %" VL_PRI64 "x\n", time_[i], what, expected_[i], data_[i]);
+            }
+            if (note) {
+                note(i);
+            }
+        }
+        VL_PRINTF("Checked %zu %s at the end in %.3f ms, %" VL_PRI64 "u errors\n",
+                data_.size(), what, check_seconds_ * 1000.0, mismatches_);
+    }
+
+  private:
+    // One entry per sample in each
+    std::vector<uint64_t> time_;
+    std::vector<uint8_t> valid_;
+    std::vector<uint64_t> data_;
+    std::vector<uint64_t> expected_;
+
+    uint64_t mismatches_ = 0;
+    double check_seconds_ = 0.0;
+};
+
+#endif
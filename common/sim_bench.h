@@ -0,0 +1,173 @@
+#ifndef SIM_BENCH_H
+#define SIM_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim_args.h"
+
+// Simulation speed benchmarks.
+//
+// A benchmark runs a workload of +bench_size operations +bench_repeat times
+// and writes the results as JSON to +bench_json (stdout if not given), so a
+// script can compare them across design or Verilator flag changes.
+//
+// The workload builds its model, calls run.start(), does the work, calls
+// run.stop() and fills in what it did. Only the time between start() and
+// stop() is measured.
+
+class BenchRun {
+  public:
+    void start() {
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        wall_seconds = elapsed.count();
+    }
+
+    static double rate(uint64_t count, double seconds) {
+        return (seconds > 0.0) ? (double)count / seconds : 0.0;
+    }
+
+    double wall_seconds = 0.0;
+    uint64_t cycles = 0;
+    uint64_t evals = 0;
+    uint64_t transactions = 0;
+    uint64_t errors = 0;
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+class SimBench {
+  public:
+    SimBench(const char *name, const SimArgs &args, uint64_t default_size)
+        : name_{name}
+        , size_{args.u64("bench_size", default_size)}
+        , repeat_{args.u64("bench_repeat", 5)}
+        , json_path_{args.str("bench_json", "-")} {
+        if (repeat_ == 0) {
+            repeat_ = 1;
+        }
+    }
+
+    uint64_t size() const { return size_; }
+
+    // Anything else worth recording about the build, e.g. the trace setting
+    void add_info(const char *key, const std::string &value) {
+        info_.push_back({key, value});
+    }
+
+    // How the model was built: whether tracing is compiled in, and the
+    // FLAVOR and PGO it was built with (see the Makefiles), so results from
+    // different builds can be told apart
+    void add_build_info() {
+#if VM_TRACE
+        add_info("trace", "compiled");
+#else
+        add_info("trace", "none");
+#endif
+#ifdef SIM_FAST
+        add_info("flavor", "fast");
+#else
+        add_info("flavor", "debug");
+#endif
+#ifdef SIM_PGO
+        add_info("pgo", "yes");
+#else
+        add_info("pgo", "no");
+#endif
+    }
+
+    template <typename Workload>
+    void run(Workload workload) {
+        for (uint64_t i = 0; i < repeat_; i++) {
+            BenchRun run;
+            run.start();
+            workload(size_, run);
+            if (run.wall_seconds == 0.0) {
+                run.stop();
+            }
+            runs_.push_back(run);
+        }
+    }
+
+    // Returns false if any run had errors, since timing a broken design
+    // doesn't mean much
+    bool report() const {
+        FILE *out = stdout;
+        if (json_path_ != "-") {
+            out = std::fopen(json_path_.c_str(), "w");
+            if (out == nullptr) {
+                std::fprintf(stderr, "Can't open %s for the benchmark results\n",
+                             json_path_.c_str());
+                return false;
+            }
+        }
+
+        uint64_t errors = 0;
+        std::fprintf(out, "{\n");
+        std::fprintf(out, "  \"benchmark\": \"%s\",\n", name_.c_str());
+        for (const std::pair<std::string, std::string> &info : info_) {
+            std::fprintf(out, "  \"%s\": \"%s\",\n", info.first.c_str(),
+                         info.second.c_str());
+        }
+        std::fprintf(out, "  \"size\": %" PRIu64 ",\n", size_);
+        std::fprintf(out, "  \"repeat\": %" PRIu64 ",\n", repeat_);
+        std::fprintf(out, "  \"runs\": [\n");
+        for (size_t i = 0; i < runs_.size(); i++) {
+            std::fprintf(out, "    ");
+            print_run(out, runs_[i]);
+            std::fprintf(out, "%s\n", (i + 1 < runs_.size()) ? "," : "");
+            errors += runs_[i].errors;
+        }
+        std::fprintf(out, "  ],\n");
+
+        // The fastest run is the one least disturbed by the rest of the
+        // machine, the median shows how noisy it was
+        std::vector<BenchRun> sorted = runs_;
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const BenchRun &a, const BenchRun &b) {
+                      return a.wall_seconds < b.wall_seconds;
+                  });
+        std::fprintf(out, "  \"best\": ");
+        print_run(out, sorted.front());
+        std::fprintf(out, ",\n  \"median\": ");
+        print_run(out, sorted[sorted.size() / 2]);
+        std::fprintf(out, "\n}\n");
+
+        if (out != stdout) {
+            std::fclose(out);
+        }
+        return errors == 0;
+    }
+
+  private:
+    static void print_run(FILE *out, const BenchRun &run) {
+        std::fprintf(out, "{\"wall_s\": %.6f, \"cycles\": %" PRIu64 ", \
+\"evals\": %" PRIu64 ", \"transactions\": %" PRIu64 ", \"errors\": %" PRIu64 ", \
+\"cycles_per_s\": %.1f, \"evals_per_s\": %.1f, \"transactions_per_s\": %.1f}",
+                     run.wall_seconds, run.cycles, run.evals, run.transactions,
+                     run.errors,
+                     BenchRun::rate(run.cycles, run.wall_seconds),
+                     BenchRun::rate(run.evals, run.wall_seconds),
+                     BenchRun::rate(run.transactions, run.wall_seconds));
+    }
+
+    std::string name_;
+    uint64_t size_;
+    uint64_t repeat_;
+    std::string json_path_;
+    std::vector<std::pair<std::string, std::string>> info_;
+    std::vector<BenchRun> runs_;
+};
+
+#endif
@@ -0,0 +1,117 @@
+// Compares benchmark results written with +bench_json, e.g. the fast and
+// debug builds of the same model:
+//
+//     sim_bench_compare logs/bench_debug.json logs/bench_fast.json
+//
+// Prints the best run of each file and how much faster it is than the first
+// one. Only reads what SimBench writes, it isn't a JSON parser.
+//
+// Builds without Verilator:
+//
+//     c++ -O2 -o sim_bench_compare sim_bench_compare.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+struct BenchResult {
+    std::string benchmark;
+    std::string flavor;
+    std::string pgo;
+    double cycles_per_s = 0.0;
+    double evals_per_s = 0.0;
+    double transactions_per_s = 0.0;
+};
+
+static bool read_file(const char *path, std::string &text) {
+    FILE *in = std::fopen(path, "r");
+    if (in == nullptr) {
+        std::fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+    char buffer[4096];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        text.append(buffer, count);
+    }
+    std::fclose(in);
+    return true;
+}
+
+// The string value of "key": "value" from pos on, empty if there isn't one
+static std::string string_value(const std::string &text, const char *key, size_t pos = 0) {
+    std::string quoted = std::string{"\""} + key + "\": \"";
+    size_t start = text.find(quoted, pos);
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += quoted.size();
+    size_t end = text.find('"', start);
+    return (end == std::string::npos) ? "" : text.substr(start, end - start);
+}
+
+static double number_value(const std::string &text, const char *key, size_t pos) {
+    std::string quoted = std::string{"\""} + key + "\": ";
+    size_t start = text.find(quoted, pos);
+    if (start == std::string::npos) {
+        return 0.0;
+    }
+    return std::strtod(text.c_str() + start + quoted.size(), nullptr);
+}
+
+static bool read_result(const char *path, BenchResult &result) {
+    std::string text;
+    if (!read_file(path, text)) {
+        return false;
+    }
+    size_t best = text.find("\"best\": {");
+    if (best == std::string::npos) {
+        std::fprintf(stderr, "%s has no best run, is it from +bench_json?\n", path);
+        return false;
+    }
+    result.benchmark = string_value(text, "benchmark");
+    result.flavor = string_value(text, "flavor");
+    result.pgo = string_value(text, "pgo");
+    result.cycles_per_s = number_value(text, "cycles_per_s", best);
+    result.evals_per_s = number_value(text, "evals_per_s", best);
+    result.transactions_per_s = number_value(text, "transactions_per_s", best);
+    return true;
+}
+
+static double speedup(double rate, double base) {
+    return (base > 0.0) ? rate / base : 0.0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <bench.json>...\n", argv[0]);
+        return 1;
+    }
+
+    BenchResult base;
+    std::printf("%-28s %-8s %-4s %14s %14s %16s %8s\n", "file", "flavor", "pgo",
+                "cycles/s", "evals/s", "transactions/s", "speedup");
+    for (int i = 1; i < argc; i++) {
+        BenchResult result;
+        if (!read_result(argv[i], result)) {
+            return 1;
+        }
+        if (i == 1) {
+            base = result;
+        }
+        else if (result.benchmark != base.benchmark) {
+            std::fprintf(stderr, "%s is a %s benchmark, not %s\n", argv[i],
+                         result.benchmark.c_str(), base.benchmark.c_str());
+            return 1;
+        }
+        // Cycles are what the builds have in common, a cycle costs the same
+        // work in either of them
+        std::printf("%-28s %-8s %-4s %14.1f %14.1f %16.1f %7.2fx\n", argv[i],
+                    result.flavor.empty() ? "-" : result.flavor.c_str(),
+                    result.pgo.empty() ? "-" : result.pgo.c_str(),
+                    result.cycles_per_s, result.evals_per_s, result.transactions_per_s,
+                    speedup(result.cycles_per_s, base.cycles_per_s));
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Drives the clk input of a Verilated model with a fixed period.
+//
+// Nothing in a synchronous design changes between clock edges unless the
+// testbench changes an input, so instead of calling eval() on every
+// timeprecision step, the clock only evaluates the model on the edge and then
+// jumps the context time to the end of the half cycle in one go.
+//
+// The edge is evaluated 1 step after the start of the half cycle, which is
+// where the old per-step loop first saw it, so $time in the model, the
+// timestamps in the trace and the times printed by the harness are the same
+// as before.
+//
+// Inputs changed by the testbench before calling half_cycle() are evaluated
+// together with the edge, just like they used to be. If the testbench needs
+// to see the combinational effect of an input change without an edge, call
+// eval().
+//
+// Observers added with add_observer() run after every evaluation, which is
+// where recorders and monitors that watch the ports should sample them.
+//
+// When the harness knows the next cycles can't change anything, because the
+// inputs stay the same and the last cycle left the state as it was, it can
+// skip_cycles() instead. Time moves on as if they had been run, but the model
+// isn't evaluated and the observers don't see them, so a trace shows the
+// clock stopped for that long.
+template <typename Top>
+class SimClock {
+  public:
+    SimClock(VerilatedContext *contextp, Top *top, uint64_t half_cycle_ns)
+        : contextp_{contextp}
+        , top_{top}
+        , half_cycle_ns_{half_cycle_ns} {}
+
+    void half_cycle() {
+        top_->clk = !top_->clk;
+        contextp_->timeInc(1);
+        eval();
+        contextp_->timeInc(half_cycle_ns_ - 1);
+        half_cycles_++;
+    }
+
+    void cycle() {
+        half_cycle();
+        half_cycle();
+    }
+
+    // Moves time on by n whole cycles without evaluating anything. Must be
+    // called at the same point in the cycle as cycle()
+    void skip_cycles(uint64_t n) {
+        contextp_->timeInc(n * 2 * half_cycle_ns_);
+        half_cycles_ += 2 * n;
+        skipped_cycles_ += n;
+    }
+
+    // Evaluate input changes made in between edges without moving time
+    void eval() {
+        top_->eval();
+        evals_++;
+        for (const std::function<void()> &observer : observers_) {
+            observer();
+        }
+    }
+
+    void add_observer(const std::function<void()> &observer) {
+        observers_.push_back(observer);
+    }
+
+    VerilatedContext *contextp() const { return contextp_; }
+    Top *top() const { return top_; }
+
+    uint64_t half_cycle_ns() const { return half_cycle_ns_; }
+    uint64_t evals() const { return evals_; }
+    uint64_t half_cycles() const { return half_cycles_; }
+    uint64_t cycles() const { return half_cycles_ / 2; }
+    // Included in cycles()
+    uint64_t skipped_cycles() const { return skipped_cycles_; }
+
+  private:
+    VerilatedContext *contextp_;
+    Top *top_;
+    uint64_t half_cycle_ns_;
+
+    uint64_t evals_ = 0;
+    uint64_t half_cycles_ = 0;
+    uint64_t skipped_cycles_ = 0;
+
+    std::vector<std::function<void()>> observers_;
+};
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef SIM_COMB_H
+#define SIM_COMB_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_shard.h"
+
+// Exhaustive checking of combinational blocks.
+//
+// A combinational block has no state, so every input vector can be checked on
+// its own, in any order and on any copy of the model. The harness numbers its
+// vectors and describes the block with a CombBlock: how to drive vector i onto
+// the inputs, how to read the output, and the expected outputs for a run of
+// vectors.
+//
+// CombLanes steps several copies of the model in lockstep, one vector per
+// lane: all the lanes get their inputs, then all are evaluated, then all the
+// outputs are gathered into one array. Once a chunk is gathered, the
+// reference fills in the expected outputs with a plain loop over vector
+// numbers and the two arrays are compared with a branch-free count, which the
+// compiler vectorizes. Only a chunk with mismatches is gone over again to
+// find which vectors failed.
+//
+// run_comb() spreads the chunks over threads with run_sharded(), each thread
+// with lanes of its own.
+template <typename Top>
+struct CombBlock {
+    // Drives the inputs for vector i
+    void (*apply)(Top *top, uint64_t i);
+    // Reads the output
+    uint64_t (*sample)(const Top *top);
+    // Fills in expected[] for vectors first to first + count - 1
+    void (*reference)(uint64_t first, uint64_t count, uint64_t *expected);
+    // Prints the inputs of vector i, for failures
+    void (*describe)(uint64_t i);
+};
+
+template <typename Top>
+class CombLanes {
+  public:
+    CombLanes(const CombBlock<Top> &block, unsigned num_lanes, size_t chunk_size)
+        : block_(block)
+        , actual_(chunk_size)
+        , expected_(chunk_size) {
+        // run() steps through the vectors a lane's worth at a time
+        if (num_lanes == 0) {
+            num_lanes = 1;
+        }
+        // A context each, as the lanes are whole models of their own
+        for (unsigned lane = 0; lane < num_lanes; lane++) {
+            contexts_.emplace_back(new VerilatedContext);
+            contexts_.back()->debug(0);
+            contexts_.back()->randReset(0);
+            tops_.emplace_back(new Top{contexts_.back().get(), "TOP"});
+        }
+    }
+
+    uint64_t evals() const { return evals_; }
+
+    // Checks vectors first to first + count - 1, count at most the chunk
+    // size. Returns the number that failed and adds up to max_failed of them
+    // to failed
+    uint64_t run(uint64_t first, uint64_t count, std::vector<uint64_t> &failed,
+                 size_t max_failed) {
+        size_t num_lanes = tops_.size();
+        for (uint64_t base = 0; base < count; base += num_lanes) {
+            size_t lanes = (base + num_lanes < count) ? num_lanes : (size_t)(count - base);
+            for (size_t lane = 0; lane < lanes; lane++) {
+                block_.apply(tops_[lane].get(), first + base + lane);
+            }
+            for (size_t lane = 0; lane < lanes; lane++) {
+                tops_[lane]->eval();
+            }
+            for (size_t lane = 0; lane < lanes; lane++) {
+                actual_[base + lane] = block_.sample(tops_[lane].get());
+            }
+            evals_ += lanes;
+        }
+
+        block_.reference(first, count, expected_.data());
+
+        const uint64_t *actual = actual_.data();
+        const uint64_t *expected = expected_.data();
+        uint64_t mismatches = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            mismatches += (uint64_t)(actual[i] != expected[i]);
+        }
+
+        if (mismatches != 0) {
+            for (uint64_t i = 0; (i < count) && (failed.size() < max_failed); i++) {
+                if (actual[i] != expected[i]) {
+                    failed.push_back(first + i);
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    // The output and the expected output of the vector at offset i into the
+    // last chunk run
+    uint64_t actual(uint64_t i) const { return actual_[i]; }
+    uint64_t expected(uint64_t i) const { return expected_[i]; }
+
+  private:
+    CombBlock<Top> block_;
+    std::vector<std::unique_ptr<VerilatedContext>> contexts_;
+    std::vector<std::unique_ptr<Top>> tops_;
+    std::vector<uint64_t> actual_;
+    std::vector<uint64_t> expected_;
+    uint64_t evals_ = 0;
+};
+
+struct CombStats {
+    uint64_t vectors = 0;
+    uint64_t evals = 0;
+    uint64_t failed = 0;
+    double seconds = 0.0;
+    ShardStats shards;
+};
+
+// Checks vectors 0 to num_vectors - 1 of block on num_workers threads with
+// num_lanes lanes each, chunk_size vectors at a time. Prints the first
+// max_reported failures in vector order and a summary.
+template <typename Top>
+CombStats run_comb(const CombBlock<Top> &block, uint64_t num_vectors,
+                   unsigned num_workers, unsigned num_lanes, size_t chunk_size,
+                   size_t max_reported) {
+    uint64_t num_chunks = (num_vectors + chunk_size - 1) / chunk_size;
+    // The same as run_sharded() does, so there's an evals slot per worker,
+    // and CombLanes does, so the summary has the lanes that ran
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+    if (num_lanes == 0) {
+        num_lanes = 1;
+    }
+
+    // One slot per chunk, so the report doesn't depend on which worker ran
+    // which chunk
+    struct ChunkResult {
+        uint64_t failed = 0;
+        std::vector<uint64_t> vectors;
+        std::vector<uint64_t> actual;
+        std::vector<uint64_t> expected;
+    };
+    std::vector<ChunkResult> results(num_chunks);
+    std::vector<uint64_t> evals(num_workers, 0);
+
+    struct CombWorker {
+        unsigned index;
+        CombLanes<Top> lanes;
+    };
+
+    CombStats stats;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    stats.shards = run_sharded<CombWorker>(num_workers, num_chunks,
+        [&](unsigned worker) {
+            return std::unique_ptr<CombWorker>{
+                new CombWorker{worker, CombLanes<Top>{block, num_lanes, chunk_size}}};
+        },
+        [&](CombWorker &worker, uint64_t chunk) {
+            uint64_t first = chunk * chunk_size;
+            uint64_t count = (first + chunk_size < num_vectors)
+                           ? chunk_size : num_vectors - first;
+            ChunkResult &result = results[chunk];
+            result.failed = worker.lanes.run(first, count, result.vectors, max_reported);
+            for (uint64_t vector : result.vectors) {
+                result.actual.push_back(worker.lanes.actual(vector - first));
+                result.expected.push_back(worker.lanes.expected(vector - first));
+            }
+            evals[worker.index] = worker.lanes.evals();
+        });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t reported = 0;
+    for (const ChunkResult &result : results) {
+        stats.failed += result.failed;
+        for (size_t i = 0; i < result.vectors.size(); i++) {
+            if (reported == max_reported) {
+                break;
+            }
+            reported++;
+            VL_PRINTF("ERROR: vector %" VL_PRI64 "u Expected: %" VL_PRI64 "x, \
+Actual: %" VL_PRI64 "x\n", result.vectors[i], result.expected[i], result.actual[i]);
+            block.describe(result.vectors[i]);
+        }
+    }
+    if (stats.failed > reported) {
+        VL_PRINTF("... and %" VL_PRI64 "u more failures\n", stats.failed - reported);
+    }
+
+    stats.vectors = num_vectors;
+    for (uint64_t worker_evals : evals) {
+        stats.evals += worker_evals;
+    }
+    stats.seconds = elapsed.count();
+    VL_PRINTF("Lockstep check: %" VL_PRI64 "u vectors on %u workers with %u lanes, \
+%" VL_PRI64 "u chunks (%" VL_PRI64 "u stolen), %.0f vectors per second, \
+%" VL_PRI64 "u failures\n",
+            stats.vectors, stats.shards.workers, num_lanes, stats.shards.chunks,
+            stats.shards.stolen, (stats.seconds > 0.0) ? stats.vectors / stats.seconds : 0.0,
+            stats.failed);
+    return stats;
+}
+
+#endif
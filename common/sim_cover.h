@@ -0,0 +1,134 @@
+#ifndef SIM_COVER_H
+#define SIM_COVER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Functional coverage, counted by the harness.
+//
+// Goals are points the random stimulus has to hit some number of times, e.g.
+// "lot filled up" or "read bypassed a write". Value groups are for things
+// whose interesting values the harness doesn't know up front, like the states
+// of an FSM someone else wrote: every value gets a counter, and a value seen
+// for the first time counts as progress, but isn't a goal.
+//
+// Hitting a point is an increment and a compare, so it can go in the
+// innermost loop. Every so often the harness calls done() with how far it's
+// got (cycles, transactions), which is true once every goal is met or nothing
+// new has been covered for plateau steps, so a random run can stop there
+// instead of going on with stimulus that isn't finding anything.
+class SimCoverage {
+  public:
+    // plateau is how many steps without anything new done() puts up with, 0
+    // for no limit
+    explicit SimCoverage(uint64_t plateau)
+        : plateau_{plateau} {}
+
+    // Returns the point to hit()
+    unsigned add_goal(const std::string &name, uint64_t goal = 1) {
+        goals_.push_back({name, goal});
+        goal_hits_.push_back(0);
+        return (unsigned)(goals_.size() - 1);
+    }
+
+    // Values 0 to num_values - 1. Returns the group to hit_value()
+    unsigned add_values(const std::string &name, uint64_t num_values) {
+        groups_.push_back({name, value_hits_.size(), num_values});
+        value_hits_.resize(value_hits_.size() + num_values, 0);
+        return (unsigned)(groups_.size() - 1);
+    }
+
+    void hit(unsigned point) {
+        if (++goal_hits_[point] == goals_[point].goal) {
+            goals_met_++;
+            progress_++;
+        }
+    }
+
+    void hit_value(unsigned group, uint64_t value) {
+        if (value_hits_[groups_[group].first + value]++ == 0) {
+            progress_++;
+        }
+    }
+
+    bool goals_met() const { return goals_met_ == goals_.size(); }
+
+    // now is how far the run has got, in whatever steps plateau is in
+    bool done(uint64_t now) {
+        if (progress_ != last_progress_) {
+            last_progress_ = progress_;
+            last_progress_step_ = now;
+        }
+        if (goals_met()) {
+            stop_reason_ = "every goal met";
+            return true;
+        }
+        if ((plateau_ != 0) && (now - last_progress_step_ >= plateau_)) {
+            stop_reason_ = "nothing new covered";
+            return true;
+        }
+        return false;
+    }
+
+    // Why done() returned true, nullptr if it hasn't
+    const char *stop_reason() const { return stop_reason_; }
+    // The step anything was last covered at, as of the last done()
+    uint64_t last_progress_step() const { return last_progress_step_; }
+
+    void report(const char *title) const {
+        VL_PRINTF("%s coverage: %zu of %zu goals met\n", title, goals_met_, goals_.size());
+        for (size_t i = 0; i < goals_.size(); i++) {
+            VL_PRINTF("  %-32s %10" VL_PRI64 "u / %" VL_PRI64 "u%s\n",
+                    goals_[i].name.c_str(), goal_hits_[i], goals_[i].goal,
+                    (goal_hits_[i] >= goals_[i].goal) ? "" : "  MISSED");
+        }
+        for (const ValueGroup &group : groups_) {
+            uint64_t seen = 0;
+            std::string values;
+            for (uint64_t value = 0; value < group.num_values; value++) {
+                if (value_hits_[group.first + value] != 0) {
+                    seen++;
+                    values += " " + std::to_string(value);
+                }
+            }
+            VL_PRINTF("  %-32s %" VL_PRI64 "u values seen:%s\n", group.name.c_str(), seen,
+                    values.c_str());
+        }
+        if (stop_reason_ != nullptr) {
+            VL_PRINTF("  Stopped early, %s, last new coverage at step %" VL_PRI64 "u\n",
+                    stop_reason_, last_progress_step_);
+        }
+    }
+
+  private:
+    struct Goal {
+        std::string name;
+        uint64_t goal;
+    };
+
+    struct ValueGroup {
+        std::string name;
+        size_t first;
+        uint64_t num_values;
+    };
+
+    std::vector<Goal> goals_;
+    std::vector<uint64_t> goal_hits_;
+    size_t goals_met_ = 0;
+
+    std::vector<ValueGroup> groups_;
+    std::vector<uint64_t> value_hits_;
+
+    // Goals met plus values seen, so far and at the last done()
+    uint64_t progress_ = 0;
+    uint64_t last_progress_ = 0;
+    uint64_t last_progress_step_ = 0;
+    uint64_t plateau_;
+    const char *stop_reason_ = nullptr;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef SIM_FLIGHT_H
+#define SIM_FLIGHT_H
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_clock.h"
+
+// A signal kept by the flight recorder
+struct FlightSignal {
+    const char *name;
+    unsigned width;
+};
+
+// Flight recorder for the model's ports.
+//
+// Tracing a long regression with +trace writes every change of every signal
+// to disk, most of which nobody ever looks at. The flight recorder instead
+// keeps the last pre_cycles cycles of the ports in memory. When the harness
+// calls trigger() on a failure, it keeps going for post_cycles more cycles
+// and then writes the whole window out as <prefix>_<n>.vcd, so there's a
+// waveform of what led up to the failure and what came after it.
+//
+// The ports are sampled after every evaluation of the SimClock, with the
+// harness's sample function filling in one value per signal. Only the first
+// max_dumps failures get a dump.
+template <typename Top>
+class FlightRecorder {
+  public:
+    typedef void (*SampleFn)(const Top *top, uint64_t *values);
+
+    FlightRecorder(SimClock<Top> &sim, const std::vector<FlightSignal> &signals,
+                   SampleFn sample, uint64_t pre_cycles, uint64_t post_cycles,
+                   const std::string &prefix, unsigned max_dumps = 8)
+        : contextp_{sim.contextp()}
+        , top_{sim.top()}
+        , signals_{signals}
+        , sample_{sample}
+        // Two evaluations per cycle, one per edge
+        , depth_{2 * pre_cycles + 2 * post_cycles + 1}
+        , post_samples_{2 * post_cycles}
+        , prefix_{prefix}
+        , max_dumps_{max_dumps}
+        , times_(depth_)
+        , values_(depth_ * signals.size()) {
+        sim.add_observer([this]() { record(); });
+    }
+
+    // Call when a check fails. Does nothing if a dump is already coming up,
+    // since this failure will be in it
+    void trigger(const char *reason) {
+        if (pending_ || (dumps_ == max_dumps_)) {
+            return;
+        }
+        pending_ = true;
+        post_left_ = post_samples_;
+        reason_ = reason;
+        trigger_time_ = contextp_->time();
+    }
+
+    // Call at the end of the run so a failure close to the end still gets
+    // dumped, with whatever came after it
+    void finish() {
+        if (pending_) {
+            dump();
+        }
+    }
+
+    unsigned dumps() const { return dumps_; }
+
+  private:
+    void record() {
+        size_t slot = (head_ + count_) % depth_;
+        if (count_ == depth_) {
+            head_ = (head_ + 1) % depth_;
+        }
+        else {
+            count_++;
+        }
+        times_[slot] = contextp_->time();
+        sample_(top_, &values_[slot * signals_.size()]);
+
+        if (pending_) {
+            if (post_left_ == 0) {
+                dump();
+            }
+            else {
+                post_left_--;
+            }
+        }
+    }
+
+    static void print_value(FILE *out, const FlightSignal &signal, uint64_t value,
+                            char id) {
+        if (signal.width == 1) {
+            std::fprintf(out, "%d%c\n", (int)(value & 1), id);
+            return;
+        }
+        std::fputc('b', out);
+        for (int bit = (int)signal.width - 1; bit >= 0; bit--) {
+            std::fputc(((bit < 64) && ((value >> bit) & 1)) ? '1' : '0', out);
+        }
+        std::fprintf(out, " %c\n", id);
+    }
+
+    void dump() {
+        pending_ = false;
+        std::string path = prefix_ + "_" + std::to_string(dumps_) + ".vcd";
+        dumps_++;
+
+        FILE *out = std::fopen(path.c_str(), "w");
+        if (out == nullptr) {
+            VL_PRINTF("Flight recorder: can't open %s\n", path.c_str());
+            return;
+        }
+
+        std::fprintf(out, "$comment %s at %" PRIu64 " $end\n", reason_.c_str(),
+                     trigger_time_);
+        std::fprintf(out, "$timescale 1ns $end\n");
+        std::fprintf(out, "$scope module TOP $end\n");
+        for (size_t i = 0; i < signals_.size(); i++) {
+            std::fprintf(out, "$var wire %u %c %s $end\n", signals_[i].width,
+                         signal_id(i), signals_[i].name);
+        }
+        std::fprintf(out, "$upscope $end\n");
+        std::fprintf(out, "$enddefinitions $end\n");
+
+        size_t num_signals = signals_.size();
+        const uint64_t *last = nullptr;
+        for (size_t n = 0; n < count_; n++) {
+            size_t slot = (head_ + n) % depth_;
+            const uint64_t *values = &values_[slot * num_signals];
+            std::fprintf(out, "#%" PRIu64 "\n", times_[slot]);
+            for (size_t i = 0; i < num_signals; i++) {
+                if ((last == nullptr) || (last[i] != values[i])) {
+                    print_value(out, signals_[i], values[i], signal_id(i));
+                }
+            }
+            last = values;
+        }
+        std::fclose(out);
+
+        VL_PRINTF("[%" VL_PRI64 "d] Flight recorder: %s, wrote %s\n",
+                  contextp_->time(), reason_.c_str(), path.c_str());
+    }
+
+    // VCD identifiers are printable characters, which is plenty for the ports
+    static char signal_id(size_t i) {
+        return (char)('!' + i);
+    }
+
+    VerilatedContext *contextp_;
+    const Top *top_;
+    std::vector<FlightSignal> signals_;
+    SampleFn sample_;
+
+    size_t depth_;
+    uint64_t post_samples_;
+    std::string prefix_;
+    unsigned max_dumps_;
+
+    // Ring buffer of samples, oldest at head_
+    std::vector<uint64_t> times_;
+    std::vector<uint64_t> values_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+
+    bool pending_ = false;
+    uint64_t post_left_ = 0;
+    std::string reason_;
+    uint64_t trigger_time_ = 0;
+    unsigned dumps_ = 0;
+};
+
+#endif
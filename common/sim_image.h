@@ -0,0 +1,189 @@
+#ifndef SIM_IMAGE_H
+#define SIM_IMAGE_H
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Memory for a processor model, loaded from a program image.
+//
+// The whole memory is one anonymous mapping of the host, and the harness
+// serves every fetch, load and store straight out of it with a pointer, so
+// a memory access costs a bounds check and a host load or store, no matter
+// how long the program runs.
+//
+// Images are either
+//   - raw binaries, loaded at address 0. The file is mapped over the start of
+//     the memory copy-on-write, so loading is free however big it is, and
+//     stores don't change the file
+//   - 32-bit little-endian ELF files, whose loadable segments are copied in
+//     once. The entry point and the address of the tohost symbol, if there is
+//     one, are picked up from the file
+//
+// Memory goes from address 0 to size - 1, and the size has to be a multiple
+// of the page size. Accesses are little-endian like RISC-V, which the host
+// has to be as well.
+class SimImage {
+  public:
+    explicit SimImage(uint64_t size)
+        : size_{size} {
+        void *base = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        base_ = (base == MAP_FAILED) ? nullptr : (uint8_t *)base;
+    }
+
+    ~SimImage() {
+        if (base_ != nullptr) {
+            munmap(base_, size_);
+        }
+    }
+
+    SimImage(const SimImage &) = delete;
+    SimImage &operator=(const SimImage &) = delete;
+
+    bool ok() const { return base_ != nullptr; }
+    uint64_t size() const { return size_; }
+    uint32_t entry() const { return entry_; }
+    // Address of the tohost symbol, false if the image doesn't have one
+    bool tohost(uint32_t &addr) const {
+        addr = tohost_;
+        return has_tohost_;
+    }
+
+    // Raw binary or ELF, told apart by the ELF magic number. Prints why on
+    // failure
+    bool load(const char *path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::fprintf(stderr, "Can't open %s\n", path);
+            return false;
+        }
+        struct stat st;
+        if ((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+            std::fprintf(stderr, "%s is empty\n", path);
+            close(fd);
+            return false;
+        }
+        uint64_t file_size = (uint64_t)st.st_size;
+        void *file = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (file == MAP_FAILED) {
+            std::fprintf(stderr, "Can't map %s\n", path);
+            close(fd);
+            return false;
+        }
+
+        bool loaded;
+        if ((file_size >= SELFMAG) && (std::memcmp(file, ELFMAG, SELFMAG) == 0)) {
+            loaded = load_elf(path, (const uint8_t *)file, file_size);
+        }
+        else {
+            loaded = load_raw(path, fd, file_size);
+        }
+        munmap(file, file_size);
+        close(fd);
+        return loaded;
+    }
+
+    // For images built by the harness itself
+    void write32(uint32_t addr, uint32_t value) {
+        std::memcpy(base_ + addr, &value, sizeof(value));
+    }
+
+    bool in_range(uint32_t addr, uint32_t bytes) const {
+        return (uint64_t)addr + bytes <= size_;
+    }
+
+    // The word at addr, which must be in range and 4-byte aligned
+    uint32_t *word(uint32_t addr) {
+        return (uint32_t *)(base_ + addr);
+    }
+
+  private:
+    bool load_raw(const char *path, int fd, uint64_t file_size) {
+        if (file_size > size_) {
+            std::fprintf(stderr, "%s is %" PRIu64 " bytes, bigger than the %" PRIu64 " byte \
+memory\n", path, file_size, size_);
+            return false;
+        }
+        if (mmap(base_, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0)
+                == MAP_FAILED) {
+            std::fprintf(stderr, "Can't map %s into memory\n", path);
+            return false;
+        }
+        entry_ = 0;
+        return true;
+    }
+
+    bool load_elf(const char *path, const uint8_t *file, uint64_t file_size) {
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)file;
+        if ((file_size < sizeof(Elf32_Ehdr)) || (ehdr->e_ident[EI_CLASS] != ELFCLASS32)
+                || (ehdr->e_ident[EI_DATA] != ELFDATA2LSB)) {
+            std::fprintf(stderr, "%s isn't a 32-bit little-endian ELF file\n", path);
+            return false;
+        }
+        if ((ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf32_Phdr) > file_size)
+                || (ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf32_Shdr) > file_size)) {
+            std::fprintf(stderr, "%s is cut short\n", path);
+            return false;
+        }
+
+        const Elf32_Phdr *phdrs = (const Elf32_Phdr *)(file + ehdr->e_phoff);
+        for (unsigned i = 0; i < ehdr->e_phnum; i++) {
+            const Elf32_Phdr &phdr = phdrs[i];
+            if ((phdr.p_type != PT_LOAD) || (phdr.p_memsz == 0)) {
+                continue;
+            }
+            if (((uint64_t)phdr.p_paddr + phdr.p_memsz > size_)
+                    || ((uint64_t)phdr.p_offset + phdr.p_filesz > file_size)
+                    || (phdr.p_filesz > phdr.p_memsz)) {
+                std::fprintf(stderr, "%s: segment at %08x doesn't fit in the %" PRIu64 " byte \
+memory\n", path, phdr.p_paddr, size_);
+                return false;
+            }
+            // The rest of memsz is .bss, which the fresh mapping has as 0
+            std::memcpy(base_ + phdr.p_paddr, file + phdr.p_offset, phdr.p_filesz);
+        }
+        entry_ = ehdr->e_entry;
+
+        // tohost from the symbol table, if it wasn't stripped
+        const Elf32_Shdr *shdrs = (const Elf32_Shdr *)(file + ehdr->e_shoff);
+        for (unsigned i = 0; i < ehdr->e_shnum; i++) {
+            const Elf32_Shdr &symtab = shdrs[i];
+            if ((symtab.sh_type != SHT_SYMTAB) || (symtab.sh_link >= ehdr->e_shnum)) {
+                continue;
+            }
+            const Elf32_Shdr &strtab = shdrs[symtab.sh_link];
+            if ((symtab.sh_offset + (uint64_t)symtab.sh_size > file_size)
+                    || (strtab.sh_offset + (uint64_t)strtab.sh_size > file_size)) {
+                continue;
+            }
+            const Elf32_Sym *syms = (const Elf32_Sym *)(file + symtab.sh_offset);
+            const char *names = (const char *)(file + strtab.sh_offset);
+            for (uint64_t j = 0; j < symtab.sh_size / sizeof(Elf32_Sym); j++) {
+                if ((syms[j].st_name < strtab.sh_size)
+                        && (std::strncmp(names + syms[j].st_name, "tohost",
+                                         strtab.sh_size - syms[j].st_name) == 0)) {
+                    tohost_ = syms[j].st_value;
+                    has_tohost_ = true;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint8_t *base_;
+    uint64_t size_;
+    uint32_t entry_ = 0;
+    uint32_t tohost_ = 0;
+    bool has_tohost_ = false;
+};
+
+#endif
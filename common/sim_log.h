@@ -0,0 +1,323 @@
+#ifndef SIM_LOG_H
+#define SIM_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sim_args.h"
+
+// Binary event log.
+//
+// Status lines printed every cycle cost far more to format than the
+// simulation does to run. With +log, the harness's events instead go into a
+// preallocated ring buffer as fixed size records of the time, the event and
+// its values, and a writer thread copies them out to logs/events.bin (or
+// +log=<path>) in the background. sim_log_decode prints a log file as the
+// same text the harness would have printed.
+//
+// Without +log, events are printed straight away as before. Either way, only
+// events at or below +log_level are kept:
+//     1  errors
+//     2  status, the default
+//     3  debug
+//
+// Each event is a printf format that gets the time and then its values, all
+// as uint64_t cut down to the size the conversion asks for. The formats go in
+// the file header, so the decoder doesn't need to know the harness.
+//
+// This file doesn't use Verilator, so the decoder builds without it.
+
+#define SIM_LOG_ERROR 1
+#define SIM_LOG_STATUS 2
+#define SIM_LOG_DEBUG 3
+
+#define SIM_LOG_MAX_VALUES 6
+// Records in the ring buffer, change with +log_records
+#define SIM_LOG_DEFAULT_RECORDS (1 << 16)
+
+static const char sim_log_magic[8] = {'S', 'I', 'M', 'L', 'O', 'G', 0, 1};
+
+struct SimLogEvent {
+    unsigned level;
+    const char *name;
+    const char *format;
+};
+
+struct SimLogRecord {
+    uint64_t time;
+    uint16_t event;
+    uint16_t num_values;
+    uint32_t reserved;
+    uint64_t values[SIM_LOG_MAX_VALUES];
+};
+
+// Formats one record with its event's format, adding it to out
+static inline void sim_log_format(std::string &out, const char *format, uint64_t time,
+                                  const uint64_t *values, unsigned num_values) {
+    char text[64];
+    unsigned next = 0;
+    const char *p = format;
+    while (*p != '\0') {
+        if (*p != '%') {
+            out.push_back(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            out.push_back('%');
+            p += 2;
+            continue;
+        }
+
+        // Copy the flags, width and precision, and work out the size of the
+        // argument from the length modifier
+        char spec[32];
+        size_t len = 0;
+        spec[len++] = *p++;
+        while ((*p != '\0') && std::strchr("-+ #0123456789.", *p) && (len < 24)) {
+            spec[len++] = *p++;
+        }
+        unsigned bits = 32;
+        if ((p[0] == 'h') && (p[1] == 'h')) {
+            bits = 8;
+            p += 2;
+        }
+        else if (p[0] == 'h') {
+            bits = 16;
+            p++;
+        }
+        else {
+            while ((*p == 'l') || (*p == 'j') || (*p == 'z') || (*p == 't')) {
+                bits = 64;
+                p++;
+            }
+        }
+        char conversion = *p;
+        if (conversion == '\0') {
+            break;
+        }
+        p++;
+
+        uint64_t value = 0;
+        if (next == 0) {
+            value = time;
+        }
+        else if (next <= num_values) {
+            value = values[next - 1];
+        }
+        next++;
+        if (bits < 64) {
+            value &= (1ULL << bits) - 1;
+        }
+
+        spec[len++] = 'l';
+        spec[len++] = 'l';
+        spec[len++] = conversion;
+        spec[len] = '\0';
+        if ((conversion == 'd') || (conversion == 'i')) {
+            // Sign extend from the size the format asked for
+            int64_t signed_value = (int64_t)(value << (64 - bits)) >> (64 - bits);
+            std::snprintf(text, sizeof(text), spec, (long long)signed_value);
+            out += text;
+        }
+        else if (std::strchr("uxXo", conversion)) {
+            std::snprintf(text, sizeof(text), spec, (unsigned long long)value);
+            out += text;
+        }
+        else if (conversion == 'c') {
+            out.push_back((char)value);
+        }
+        else {
+            out.push_back('?');
+        }
+    }
+}
+
+class SimLog {
+  public:
+    // tag goes on the end of the file name, for harnesses with one log per
+    // model, e.g. logs/events_reset.bin
+    SimLog(const SimArgs &args, const std::vector<SimLogEvent> &events,
+           const char *tag = nullptr)
+        : events_{events}
+        , level_{(unsigned)args.u64("log_level", SIM_LOG_STATUS)} {
+        if (!args.flag("log")) {
+            return;
+        }
+
+        path_ = args.str("log", "logs/events.bin");
+        if (tag != nullptr) {
+            size_t dot = path_.rfind('.');
+            size_t slash = path_.rfind('/');
+            if ((dot == std::string::npos)
+                    || ((slash != std::string::npos) && (dot < slash))) {
+                dot = path_.size();
+            }
+            path_.insert(dot, std::string{"_"} + tag);
+        }
+        file_ = std::fopen(path_.c_str(), "wb");
+        if (file_ == nullptr) {
+            std::printf("Can't open %s, logging as text\n", path_.c_str());
+            return;
+        }
+        write_header();
+
+        // Rounded up to a power of 2
+        uint64_t records = 2;
+        while (records < args.u64("log_records", SIM_LOG_DEFAULT_RECORDS)) {
+            records <<= 1;
+        }
+        ring_.resize(records);
+        mask_ = records - 1;
+        writer_ = std::thread{[this]() { write_loop(); }};
+    }
+
+    ~SimLog() {
+        close();
+    }
+
+    SimLog(const SimLog &) = delete;
+    SimLog &operator=(const SimLog &) = delete;
+
+    bool enabled(unsigned event) const {
+        return events_[event].level <= level_;
+    }
+
+    void log(unsigned event, uint64_t time, std::initializer_list<uint64_t> values) {
+        if (!enabled(event)) {
+            return;
+        }
+        if (file_ == nullptr) {
+            // In one go, so lines from models on other threads don't get mixed in
+            std::string text;
+            sim_log_format(text, events_[event].format, time, values.begin(),
+                           (unsigned)values.size());
+            std::fputs(text.c_str(), stdout);
+            return;
+        }
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        // Wait for the writer if it's fallen a whole buffer behind
+        while (head - tail_.load(std::memory_order_acquire) == ring_.size()) {
+            stalls_++;
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+
+        SimLogRecord &record = ring_[head & mask_];
+        record.time = time;
+        record.event = (uint16_t)event;
+        record.num_values = 0;
+        record.reserved = 0;
+        for (uint64_t value : values) {
+            if (record.num_values == SIM_LOG_MAX_VALUES) {
+                break;
+            }
+            record.values[record.num_values++] = value;
+        }
+        head_.store(head + 1, std::memory_order_release);
+        logged_++;
+
+        // Don't bother the writer for every record
+        if (((head + 1) & (mask_ >> 1)) == 0) {
+            wake_.notify_one();
+        }
+    }
+
+    // Writes out whatever is left and stops the writer
+    void close() {
+        if (file_ == nullptr) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard{lock_};
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+        std::fclose(file_);
+        file_ = nullptr;
+        std::printf("Logged %" PRIu64 " events to %s, waited on the writer %" PRIu64 " \
+times\n", logged_, path_.c_str(), stalls_);
+    }
+
+  private:
+    void write_string(const char *str) {
+        uint32_t len = (uint32_t)std::strlen(str);
+        std::fwrite(&len, sizeof(len), 1, file_);
+        std::fwrite(str, 1, len, file_);
+    }
+
+    void write_header() {
+        std::fwrite(sim_log_magic, sizeof(sim_log_magic), 1, file_);
+        uint32_t num_events = (uint32_t)events_.size();
+        std::fwrite(&num_events, sizeof(num_events), 1, file_);
+        for (const SimLogEvent &event : events_) {
+            uint32_t level = event.level;
+            std::fwrite(&level, sizeof(level), 1, file_);
+            write_string(event.name);
+            write_string(event.format);
+        }
+    }
+
+    void write_loop() {
+        while (true) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock{lock_};
+                wake_.wait_for(lock, std::chrono::milliseconds(10));
+                stopping = stop_;
+            }
+
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            uint64_t head = head_.load(std::memory_order_acquire);
+            while (tail != head) {
+                // Up to the end of the buffer, then around
+                uint64_t start = tail & mask_;
+                uint64_t count = head - tail;
+                if (start + count > ring_.size()) {
+                    count = ring_.size() - start;
+                }
+                std::fwrite(&ring_[start], sizeof(SimLogRecord), count, file_);
+                tail += count;
+                tail_.store(tail, std::memory_order_release);
+            }
+
+            if (stopping) {
+                break;
+            }
+        }
+    }
+
+    std::vector<SimLogEvent> events_;
+    unsigned level_;
+
+    std::string path_;
+    FILE *file_ = nullptr;
+
+    std::vector<SimLogRecord> ring_;
+    uint64_t mask_ = 0;
+    // Records are added at head_ by the simulation and written out from tail_
+    // by the writer
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};
+
+    std::thread writer_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    uint64_t logged_ = 0;
+    uint64_t stalls_ = 0;
+};
+
+#endif
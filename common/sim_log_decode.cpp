@@ -0,0 +1,89 @@
+// Prints binary event logs written with +log as the text the harness would
+// have printed, e.g.
+//
+//     sim_log_decode logs/events.bin
+//
+// Builds without Verilator:
+//
+//     c++ -O2 -o sim_log_decode sim_log_decode.cpp
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sim_log.h"
+
+static bool read_string(FILE *in, std::string &str) {
+    uint32_t len;
+    if (std::fread(&len, sizeof(len), 1, in) != 1) {
+        return false;
+    }
+    str.resize(len);
+    return (len == 0) || (std::fread(&str[0], 1, len, in) == len);
+}
+
+static bool decode(const char *path) {
+    FILE *in = std::fopen(path, "rb");
+    if (in == nullptr) {
+        std::fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+
+    char magic[sizeof(sim_log_magic)];
+    uint32_t num_events = 0;
+    if ((std::fread(magic, sizeof(magic), 1, in) != 1)
+            || (std::memcmp(magic, sim_log_magic, sizeof(magic)) != 0)
+            || (std::fread(&num_events, sizeof(num_events), 1, in) != 1)) {
+        std::fprintf(stderr, "%s isn't an event log\n", path);
+        std::fclose(in);
+        return false;
+    }
+
+    std::vector<std::string> formats(num_events);
+    for (uint32_t i = 0; i < num_events; i++) {
+        uint32_t level;
+        std::string name;
+        if ((std::fread(&level, sizeof(level), 1, in) != 1)
+                || !read_string(in, name) || !read_string(in, formats[i])) {
+            std::fprintf(stderr, "%s: header is cut short\n", path);
+            std::fclose(in);
+            return false;
+        }
+    }
+
+    std::vector<SimLogRecord> records(4096);
+    std::string text;
+    size_t count;
+    bool ok = true;
+    while ((count = std::fread(records.data(), sizeof(SimLogRecord), records.size(), in)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            const SimLogRecord &record = records[i];
+            if (record.event >= num_events) {
+                std::fprintf(stderr, "%s: unknown event %u\n", path, record.event);
+                ok = false;
+                continue;
+            }
+            text.clear();
+            sim_log_format(text, formats[record.event].c_str(), record.time,
+                           record.values, record.num_values);
+            std::fputs(text.c_str(), stdout);
+        }
+    }
+    std::fclose(in);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <log>...\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        ok = decode(argv[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
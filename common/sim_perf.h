@@ -0,0 +1,153 @@
+#ifndef SIM_PERF_H
+#define SIM_PERF_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Histograms of cycle counts, e.g. how long each read took to come back.
+//
+// Counts below SIM_HIST_EXACT get a bucket each, so the percentiles of the
+// latencies these designs actually have are exact. Anything longer, like a
+// response held up by a long stall, goes in a bucket per power of 2 and its
+// percentiles are rounded down to the start of the bucket.
+#define SIM_HIST_EXACT 1024
+// Power of 2 buckets for 1024 and up, enough for any uint64_t
+#define SIM_HIST_LOG_BUCKETS (64 - 10)
+
+class SimHistogram {
+  public:
+    SimHistogram()
+        : exact_(SIM_HIST_EXACT, 0)
+        , log_(SIM_HIST_LOG_BUCKETS, 0) {}
+
+    void add(uint64_t value) {
+        if (value < SIM_HIST_EXACT) {
+            exact_[value]++;
+        }
+        else {
+            log_[63 - __builtin_clzll(value) - 10]++;
+        }
+        count_++;
+        sum_ += value;
+        if ((count_ == 1) || (value < min_)) {
+            min_ = value;
+        }
+        if (value > max_) {
+            max_ = value;
+        }
+    }
+
+    void merge(const SimHistogram &other) {
+        for (size_t i = 0; i < exact_.size(); i++) {
+            exact_[i] += other.exact_[i];
+        }
+        for (size_t i = 0; i < log_.size(); i++) {
+            log_[i] += other.log_[i];
+        }
+        if ((count_ == 0) || ((other.count_ != 0) && (other.min_ < min_))) {
+            min_ = other.min_;
+        }
+        if (other.max_ > max_) {
+            max_ = other.max_;
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return min_; }
+    uint64_t max() const { return max_; }
+
+    double mean() const {
+        return (count_ == 0) ? 0.0 : (double)sum_ / (double)count_;
+    }
+
+    // The smallest value at least percent of the values are at or below
+    uint64_t percentile(double percent) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        // Rank of the value wanted, from 1, rounded up so that at least
+        // percent of the values are at or below it. Multiplied out first, so
+        // whole percents of whole counts come out exact
+        uint64_t rank = (uint64_t)std::ceil(percent * (double)count_ / 100.0);
+        if (rank == 0) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (uint64_t value = 0; value < SIM_HIST_EXACT; value++) {
+            seen += exact_[value];
+            if (seen >= rank) {
+                return value;
+            }
+        }
+        for (size_t i = 0; i < log_.size(); i++) {
+            seen += log_[i];
+            if (seen >= rank) {
+                return 1ULL << (i + 10);
+            }
+        }
+        return max_;
+    }
+
+    // The spread in one string, e.g. for SimBench::add_info()
+    std::string percentiles() const {
+        char text[160];
+        std::snprintf(text, sizeof(text), "count %" VL_PRI64 "u mean %.2f \
+p50 %" VL_PRI64 "u p90 %" VL_PRI64 "u p99 %" VL_PRI64 "u max %" VL_PRI64 "u",
+                count_, mean(), percentile(50.0), percentile(90.0), percentile(99.0), max_);
+        return text;
+    }
+
+    // One line: how many, then the spread
+    void report(const char *name) const {
+        VL_PRINTF("  %-24s %10" VL_PRI64 "u  min %" VL_PRI64 "u  mean %.2f  \
+p50 %" VL_PRI64 "u  p90 %" VL_PRI64 "u  p99 %" VL_PRI64 "u  p99.9 %" VL_PRI64 "u  \
+max %" VL_PRI64 "u\n",
+                name, count_, min_, mean(), percentile(50.0), percentile(90.0),
+                percentile(99.0), percentile(99.9), max_);
+    }
+
+    // Every bucket with anything in it, with a bar scaled to the biggest
+    void print(const char *name) const {
+        uint64_t biggest = 0;
+        for (uint64_t bucket : exact_) {
+            biggest = (bucket > biggest) ? bucket : biggest;
+        }
+        for (uint64_t bucket : log_) {
+            biggest = (bucket > biggest) ? bucket : biggest;
+        }
+        VL_PRINTF("  %s:\n", name);
+        for (uint64_t value = 0; value < SIM_HIST_EXACT; value++) {
+            print_bucket(std::to_string(value), exact_[value], biggest);
+        }
+        for (size_t i = 0; i < log_.size(); i++) {
+            print_bucket(std::to_string(1ULL << (i + 10)) + "+", log_[i], biggest);
+        }
+    }
+
+  private:
+    void print_bucket(const std::string &label, uint64_t bucket, uint64_t biggest) const {
+        if (bucket == 0) {
+            return;
+        }
+        std::string bar((size_t)((40 * bucket + biggest - 1) / biggest), '#');
+        VL_PRINTF("    %8s %10" VL_PRI64 "u %5.1f%% %s\n", label.c_str(), bucket,
+                100.0 * (double)bucket / (double)count_, bar.c_str());
+    }
+
+    std::vector<uint64_t> exact_;
+    std::vector<uint64_t> log_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = 0;
+    uint64_t max_ = 0;
+};
+
+#endif
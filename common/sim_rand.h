@@ -0,0 +1,73 @@
+#ifndef SIM_RAND_H
+#define SIM_RAND_H
+
+#include <cstdint>
+
+// Seeded random numbers for stimulus.
+//
+// std::rand() is slow, has one global state and differs between C libraries,
+// so a run isn't reproducible on another machine. This is xoshiro256**, seeded
+// through splitmix64 so that seed 1 and seed 2 (or stream 0 and stream 1 of
+// the same seed) give unrelated sequences.
+class SimRand {
+  public:
+    explicit SimRand(uint64_t seed, uint64_t stream = 0) {
+        uint64_t mix = seed ^ (stream * 0xd1342543de82ef95ULL);
+        for (int i = 0; i < 4; i++) {
+            state_[i] = splitmix64(mix);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        uint64_t t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+
+        return result;
+    }
+
+    // Value in [0, bound). Uses the high bits, which are the best ones, and
+    // the bias is too small to matter for stimulus
+    uint64_t below(uint64_t bound) {
+        return (uint64_t)(((unsigned __int128)next() * bound) >> 64);
+    }
+
+    // Random value of the given width in bits
+    uint64_t bits(unsigned width) {
+        return (width >= 64) ? next() : (next() & ((1ULL << width) - 1));
+    }
+
+    // True numerator times out of denominator
+    bool chance(uint64_t numerator, uint64_t denominator) {
+        return below(denominator) < numerator;
+    }
+
+  private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t splitmix64(uint64_t &x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t state_[4];
+};
+
+// Verilator's random seed for the harness's +seed, for
+// VerilatedContext::randSeed(). Verilator takes 0 to mean a different seed
+// every run, so every seed is moved up by one to keep each run reproducible
+static inline int sim_verilator_seed(uint64_t seed) {
+    return (int)(seed % 0x7fffffff) + 1;
+}
+
+#endif
@@ -0,0 +1,381 @@
+// Runs many seeds of many harnesses as separate processes on all of the
+// cores, e.g.
+//
+//     sim_regress +seeds=100 regress.jobs
+//
+// Each line of the job file is one harness run:
+//
+//     # name  directory                        timeout  seeds  command
+//     mem     exercise_3/mem/assignment_files  60       all    {dir}/{obj}/V... +seed={seed}
+//
+// {dir} is replaced with the absolute path of the directory, relative to the
+// job file, {obj} with the directory the model was built in, and {seed} with
+// the seed. The timeout is in seconds, 0 for none.
+// seeds is how many seeds the job is worth running, "all" for every one; a
+// harness that doesn't depend on the seed only needs 1. The models have to be
+// built already, which the top-level Makefile's regress target does.
+//
+// Every run gets a directory of its own under <out>/<run>/<name>_<seed>, so
+// the logs/ the harnesses write don't clash, with the output in output.log.
+// The directories of runs that pass are removed unless +keep is given. A run
+// fails if it exits with anything but 0, is killed by a signal, or is still
+// going after its timeout, which kills it. Harnesses whose watchdog went off
+// exit with 124, and are reported as hung.
+//
+// One line per run is added to <out>/results.tsv, which keeps every run
+// there's been, and the failures of this one are listed at the end with the
+// command to rerun each.
+//
+// Options:
+//     +jobs=N        runs at once, the number of cores by default
+//     +seeds=N       seeds first_seed to first_seed + N - 1, 10 by default
+//     +first_seed=S  0 by default
+//     +only=name     only the jobs with this name
+//     +out=dir       regress by default
+//     +keep          keep the directories of runs that pass
+//     +obj=dir       the models' build directory, obj_dir (the debug build)
+//                    by default, obj_fast for the fast one
+//
+// Builds without Verilator:
+//
+//     c++ -O2 -o sim_regress sim_regress.cpp
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim_args.h"
+
+// How often finished and timed out runs are looked for
+#define REGRESS_POLL_MS 20
+// Failures listed at the end, the rest are in results.tsv
+#define REGRESS_MAX_REPORTED 32
+// Exit code of a harness whose watchdog went off, see sim_watchdog.h
+#define REGRESS_HANG_EXIT 124
+
+struct RegressJob {
+    std::string name;
+    std::string dir;
+    uint64_t timeout;
+    uint64_t seeds;
+    std::string command;
+};
+
+struct RegressRun {
+    const RegressJob *job;
+    uint64_t seed;
+    std::string dir;
+    std::string command;
+    pid_t pid = 0;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0.0;
+    const char *result = nullptr;
+    int exit_code = 0;
+};
+
+static std::string replace_all(std::string text, const std::string &from,
+                               const std::string &to) {
+    for (size_t pos = text.find(from); pos != std::string::npos;
+         pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+static std::string absolute_path(const std::string &path) {
+    char *resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr) {
+        return path;
+    }
+    std::string result{resolved};
+    std::free(resolved);
+    return result;
+}
+
+static bool make_dirs(const std::string &path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string part = path.substr(0, pos);
+        if ((mkdir(part.c_str(), 0755) != 0) && (errno != EEXIST)) {
+            std::fprintf(stderr, "Can't make %s: %s\n", part.c_str(), std::strerror(errno));
+            return false;
+        }
+        if (pos == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+static bool read_jobs(const char *path, std::vector<RegressJob> &jobs) {
+    FILE *in = std::fopen(path, "r");
+    if (in == nullptr) {
+        std::fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+    std::string base{path};
+    size_t slash = base.rfind('/');
+    base = (slash == std::string::npos) ? "." : base.substr(0, slash);
+
+    char line[4096];
+    unsigned line_num = 0;
+    bool ok = true;
+    while (std::fgets(line, sizeof(line), in) != nullptr) {
+        line_num++;
+        char name[256];
+        char dir[1024];
+        char seeds[32];
+        unsigned long long timeout;
+        int command_start = 0;
+        if ((line[strspn(line, " \t\r\n")] == '\0') || (line[strspn(line, " \t")] == '#')) {
+            continue;
+        }
+        if ((std::sscanf(line, "%255s %1023s %llu %31s %n", name, dir, &timeout, seeds,
+                         &command_start) != 4) || (command_start == 0)) {
+            std::fprintf(stderr, "%s:%u: expected name, directory, timeout, seeds and \
+command\n", path, line_num);
+            ok = false;
+            continue;
+        }
+        std::string command{line + command_start};
+        while (!command.empty() && ((command.back() == '\n') || (command.back() == '\r'))) {
+            command.pop_back();
+        }
+        RegressJob job;
+        job.name = name;
+        job.dir = absolute_path(base + "/" + dir);
+        job.timeout = timeout;
+        job.seeds = (std::strcmp(seeds, "all") == 0) ? UINT64_MAX
+                  : std::strtoull(seeds, nullptr, 0);
+        job.command = replace_all(command, "{dir}", job.dir);
+        jobs.push_back(job);
+    }
+    std::fclose(in);
+    return ok;
+}
+
+// Starts the run in its own directory and process group, so a timeout can kill
+// everything it started
+static bool start_run(RegressRun &run) {
+    if (!make_dirs(run.dir)) {
+        return false;
+    }
+    run.start = std::chrono::steady_clock::now();
+    run.pid = fork();
+    if (run.pid < 0) {
+        std::fprintf(stderr, "Can't fork: %s\n", std::strerror(errno));
+        return false;
+    }
+    if (run.pid == 0) {
+        setpgid(0, 0);
+        std::string log = run.dir + "/output.log";
+        int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if ((fd < 0) || (chdir(run.dir.c_str()) != 0)) {
+            _exit(127);
+        }
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+        execl("/bin/sh", "sh", "-c", run.command.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+    setpgid(run.pid, run.pid);
+    return true;
+}
+
+static void remove_dir(const std::string &dir) {
+    std::string command = "rm -rf '" + dir + "'";
+    if (std::system(command.c_str()) != 0) {
+        std::fprintf(stderr, "Can't remove %s\n", dir.c_str());
+    }
+}
+
+int main(int argc, char **argv) {
+    const SimArgs args{argc, argv};
+    const char *jobs_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '+') {
+            jobs_path = argv[i];
+        }
+    }
+    if (jobs_path == nullptr) {
+        std::fprintf(stderr, "Usage: %s [+jobs=N] [+seeds=N] [+first_seed=S] \
+[+only=name] [+out=dir] [+keep] <job file>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<RegressJob> jobs;
+    if (!read_jobs(jobs_path, jobs)) {
+        return 2;
+    }
+    const char *only = args.str("only", nullptr);
+    uint64_t num_seeds = args.u64("seeds", 10);
+    uint64_t first_seed = args.u64("first_seed", 0);
+    unsigned max_running = (unsigned)args.u64("jobs", 0);
+    if (max_running == 0) {
+        max_running = std::thread::hardware_concurrency();
+        max_running = (max_running == 0) ? 1 : max_running;
+    }
+    bool keep = args.flag("keep");
+    std::string obj = args.str("obj", "obj_dir");
+
+    // Named after when it started, so runs sort in order
+    char run_id[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(run_id, sizeof(run_id), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::string out = args.str("out", "regress");
+    if (!make_dirs(out)) {
+        return 2;
+    }
+    out = absolute_path(out);
+
+    // Seed by seed, so every job gets some seeds in early on
+    std::vector<RegressRun> runs;
+    for (uint64_t i = 0; i < num_seeds; i++) {
+        for (const RegressJob &job : jobs) {
+            if ((i >= job.seeds) || ((only != nullptr) && (job.name != only))) {
+                continue;
+            }
+            RegressRun run;
+            run.job = &job;
+            run.seed = first_seed + i;
+            run.dir = out + "/" + run_id + "/" + job.name + "_" + std::to_string(run.seed);
+            run.command = replace_all(job.command, "{obj}", obj);
+            run.command = replace_all(run.command, "{seed}", std::to_string(run.seed));
+            runs.push_back(run);
+        }
+    }
+
+    std::string db_path = out + "/results.tsv";
+    bool new_db = access(db_path.c_str(), F_OK) != 0;
+    FILE *db = std::fopen(db_path.c_str(), "a");
+    if (db == nullptr) {
+        std::fprintf(stderr, "Can't open %s\n", db_path.c_str());
+        return 2;
+    }
+    if (new_db) {
+        std::fprintf(db, "run\tjob\tseed\tresult\texit_code\tseconds\tdir\n");
+    }
+
+    std::printf("Regression %s: %zu runs of %zu jobs on %u at a time\n", run_id,
+                runs.size(), jobs.size(), max_running);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t next = 0;
+    size_t finished = 0;
+    std::vector<RegressRun *> running;
+    std::vector<const RegressRun *> failures;
+    while (finished < runs.size()) {
+        while ((next < runs.size()) && (running.size() < max_running)) {
+            RegressRun &run = runs[next++];
+            if (start_run(run)) {
+                running.push_back(&run);
+            }
+            else {
+                run.result = "error";
+                run.exit_code = -1;
+                failures.push_back(&run);
+                finished++;
+            }
+        }
+
+        bool reaped = false;
+        std::chrono::steady_clock::time_point tick = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < running.size();) {
+            RegressRun &run = *running[i];
+            std::chrono::duration<double> elapsed = tick - run.start;
+            int status;
+            pid_t pid = waitpid(run.pid, &status, WNOHANG);
+            if ((pid == 0) && (run.job->timeout != 0)
+                    && (elapsed.count() >= (double)run.job->timeout)) {
+                kill(-run.pid, SIGKILL);
+                waitpid(run.pid, &status, 0);
+                run.result = "timeout";
+                run.exit_code = -1;
+            }
+            else if (pid == 0) {
+                i++;
+                continue;
+            }
+            else if (WIFEXITED(status)) {
+                run.exit_code = WEXITSTATUS(status);
+                run.result = (run.exit_code == 0) ? "pass"
+                           : (run.exit_code == REGRESS_HANG_EXIT) ? "hang" : "fail";
+            }
+            else {
+                run.exit_code = WIFSIGNALED(status) ? -WTERMSIG(status) : -1;
+                run.result = "crash";
+            }
+            // Anything the harness left running goes with it
+            kill(-run.pid, SIGKILL);
+            run.seconds = elapsed.count();
+
+            std::fprintf(db, "%s\t%s\t%llu\t%s\t%d\t%.2f\t%s\n", run_id,
+                         run.job->name.c_str(), (unsigned long long)run.seed, run.result,
+                         run.exit_code, run.seconds, run.dir.c_str());
+            std::fflush(db);
+            finished++;
+            if (std::strcmp(run.result, "pass") == 0) {
+                if (!keep) {
+                    remove_dir(run.dir);
+                }
+            }
+            else {
+                std::printf("[%zu/%zu] %s seed %llu: %s (%d) after %.1fs\n", finished,
+                            runs.size(), run.job->name.c_str(),
+                            (unsigned long long)run.seed, run.result, run.exit_code,
+                            run.seconds);
+                std::fflush(stdout);
+                failures.push_back(&run);
+            }
+            running[i] = running.back();
+            running.pop_back();
+            reaped = true;
+        }
+        if (!reaped) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(REGRESS_POLL_MS));
+        }
+    }
+    std::fclose(db);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("\nRegression %s: %zu runs in %.1fs, %zu failed\n", run_id, runs.size(),
+                elapsed.count(), failures.size());
+    for (const RegressJob &job : jobs) {
+        size_t total = 0;
+        size_t failed = 0;
+        for (const RegressRun &run : runs) {
+            if (run.job == &job) {
+                total++;
+                failed += (std::strcmp(run.result, "pass") != 0) ? 1 : 0;
+            }
+        }
+        if (total != 0) {
+            std::printf("  %-20s %6zu runs %6zu failed\n", job.name.c_str(), total, failed);
+        }
+    }
+    for (size_t i = 0; (i < failures.size()) && (i < REGRESS_MAX_REPORTED); i++) {
+        const RegressRun &run = *failures[i];
+        if (i == 0) {
+            std::printf("\nFailures, rerun with:\n");
+        }
+        std::printf("  %s seed %llu, %s, output in %s/output.log\n    cd %s && %s\n",
+                    run.job->name.c_str(), (unsigned long long)run.seed, run.result,
+                    run.dir.c_str(), run.dir.c_str(), run.command.c_str());
+    }
+    if (failures.size() > REGRESS_MAX_REPORTED) {
+        std::printf("  ... and %zu more in %s\n", failures.size() - REGRESS_MAX_REPORTED,
+                    db_path.c_str());
+    }
+    return failures.empty() ? 0 : 1;
+}
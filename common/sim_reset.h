@@ -0,0 +1,238 @@
+#ifndef SIM_RESET_H
+#define SIM_RESET_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_clock.h"
+#include "sim_rand.h"
+#include "sim_shard.h"
+
+// Randomized reset sweep.
+//
+// A register the reset doesn't cover powers up with whatever value it
+// happens to have, and if that value can reach an output, the design behaves
+// differently from one power-up to the next. With a single seed the harness
+// never notices, since every run starts from the same random state.
+//
+// The sweep runs the same reset sequence on many models, each with its own
+// context and its own seed for Verilator's random initial values
+// (randReset(2)), followed by the same idle inputs for a few cycles. A
+// reference model with every variable initialised to 0 (randReset(0)) runs
+// the same thing, and any output that differs from it on any cycle after
+// reset is released depends on something reset didn't reach.
+//
+// A data output only counts while the valid that goes with it is high on
+// either side, so e.g. rd_resp_data may hold anything while rd_resp_val is
+// low. If the valid itself differs, that's reported against the valid.
+//
+// Each model is only a reset and a handful of cycles, so the seeds are
+// spread over workers with run_sharded() and thousands of seeds take
+// seconds. Verilator draws the random values from a per-thread generator
+// that reseeds whenever any context gets a new seed, so models are built one
+// at a time, which keeps every seed's power-on state the same as a normal run
+// with +seed=N gets.
+
+// Seeds per chunk of work handed to a worker
+#define RESET_SWEEP_CHUNK 64
+
+// An output the sweep compares
+struct ResetSignal {
+    const char *name;
+    // Index of the signal that has to be high for this one to matter, -1 if
+    // it always matters
+    int valid;
+};
+
+// What the harness provides
+template <typename Top>
+struct ResetBench {
+    // Drives the inputs to idle and puts the model through reset, leaving it
+    // just after reset is released, at the point in the cycle cycle() expects
+    void (*reset)(SimClock<Top> &sim);
+    // Fills in one value per signal
+    void (*sample)(const Top *top, uint64_t *values);
+};
+
+class ResetSweep {
+  public:
+    struct Divergence {
+        uint64_t seeds = 0;
+        uint64_t first_cycle = 0;
+        uint64_t example_seed = 0;
+        uint64_t expected = 0;
+        uint64_t actual = 0;
+    };
+
+    ResetSweep(const std::vector<ResetSignal> &signals, uint64_t cycles)
+        : signals_{signals}
+        , cycles_{cycles}
+        , diverged_(signals.size()) {}
+
+    // Sweeps num_seeds seeds from first_seed on num_workers workers, 0 for
+    // one per core. Returns the number of signals that diverged
+    template <typename Top>
+    size_t run(const ResetBench<Top> &bench, uint64_t first_seed, uint64_t num_seeds,
+               unsigned num_workers, uint64_t half_cycle_ns) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<uint64_t> expected;
+        trial(bench, 0, false, half_cycle_ns, expected);
+
+        if (num_workers == 0) {
+            num_workers = default_shard_count();
+        }
+        uint64_t num_chunks = (num_seeds + RESET_SWEEP_CHUNK - 1) / RESET_SWEEP_CHUNK;
+        std::vector<std::vector<Divergence>> results(num_chunks);
+        std::vector<uint64_t> seeds_diverged(num_chunks, 0);
+
+        struct Worker {
+            std::vector<uint64_t> actual;
+        };
+        ShardStats stats = run_sharded<Worker>(num_workers, num_chunks,
+                [](unsigned) { return std::unique_ptr<Worker>{new Worker}; },
+                [&](Worker &worker, uint64_t chunk) {
+                    std::vector<Divergence> &result = results[chunk];
+                    result.resize(signals_.size());
+                    uint64_t end = (chunk + 1) * RESET_SWEEP_CHUNK;
+                    end = (end > num_seeds) ? num_seeds : end;
+                    for (uint64_t i = chunk * RESET_SWEEP_CHUNK; i < end; i++) {
+                        trial(bench, first_seed + i, true, half_cycle_ns, worker.actual);
+                        if (compare(expected, worker.actual, first_seed + i, result)) {
+                            seeds_diverged[chunk]++;
+                        }
+                    }
+                });
+
+        // Merged in chunk order, so the example seeds don't depend on which
+        // worker got there first
+        for (uint64_t chunk = 0; chunk < num_chunks; chunk++) {
+            for (size_t i = 0; i < signals_.size(); i++) {
+                merge(diverged_[i], results[chunk][i]);
+            }
+            seeds_diverged_ += seeds_diverged[chunk];
+        }
+        seeds_ += num_seeds;
+        workers_ = stats.workers;
+        seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                  - start).count();
+
+        size_t signals_diverged = 0;
+        for (const Divergence &divergence : diverged_) {
+            signals_diverged += (divergence.seeds != 0) ? 1 : 0;
+        }
+        return signals_diverged;
+    }
+
+    const Divergence &diverged(size_t signal) const { return diverged_[signal]; }
+
+    void report(const char *title) const {
+        VL_PRINTF("%s reset sweep: %" VL_PRI64 "u seeds on %u workers, %" VL_PRI64 "u \
+cycles after reset, %" VL_PRI64 "u seeds diverged, %.0f seeds/s\n",
+                title, seeds_, workers_, cycles_, seeds_diverged_,
+                (seconds_ > 0.0) ? (double)seeds_ / seconds_ : 0.0);
+        for (size_t i = 0; i < signals_.size(); i++) {
+            const Divergence &divergence = diverged_[i];
+            if (divergence.seeds == 0) {
+                VL_PRINTF("  %-20s same for every seed\n", signals_[i].name);
+                continue;
+            }
+            VL_PRINTF("  %-20s diverged for %" VL_PRI64 "u of %" VL_PRI64 "u seeds, \
+first on cycle %" VL_PRI64 "u (+seed=%" VL_PRI64 "u: %" VL_PRI64 "x instead of %" VL_PRI64 "x)\n",
+                    signals_[i].name, divergence.seeds, seeds_, divergence.first_cycle,
+                    divergence.example_seed, divergence.actual, divergence.expected);
+        }
+    }
+
+  private:
+    // Resets a fresh model and records every signal on every cycle after
+    template <typename Top>
+    void trial(const ResetBench<Top> &bench, uint64_t seed, bool randomize,
+               uint64_t half_cycle_ns, std::vector<uint64_t> &values) {
+        std::unique_ptr<VerilatedContext> contextp;
+        std::unique_ptr<Top> top;
+        {
+            static std::mutex build_lock;
+            std::lock_guard<std::mutex> guard{build_lock};
+            contextp.reset(new VerilatedContext);
+            contextp->debug(0);
+            contextp->randReset(randomize ? 2 : 0);
+            contextp->randSeed(sim_verilator_seed(seed));
+            // Keeps the model's start-up message out of every trial
+            const char *quiet_args[] = {"sim_reset", "+quiet"};
+            contextp->commandArgs(2, quiet_args);
+            Verilated::threadContextp(contextp.get());
+            top.reset(new Top{contextp.get(), "TOP"});
+        }
+
+        SimClock<Top> sim{contextp.get(), top.get(), half_cycle_ns};
+        bench.reset(sim);
+
+        size_t n = signals_.size();
+        values.resize(cycles_ * n);
+        for (uint64_t cycle = 0; cycle < cycles_; cycle++) {
+            bench.sample(top.get(), &values[cycle * n]);
+            sim.cycle();
+        }
+        top->final();
+    }
+
+    // Records where actual differs from expected, returns true if it does
+    bool compare(const std::vector<uint64_t> &expected, const std::vector<uint64_t> &actual,
+                 uint64_t seed, std::vector<Divergence> &result) const {
+        size_t n = signals_.size();
+        bool diverged = false;
+        for (size_t i = 0; i < n; i++) {
+            int valid = signals_[i].valid;
+            for (uint64_t cycle = 0; cycle < cycles_; cycle++) {
+                const uint64_t *want = &expected[cycle * n];
+                const uint64_t *got = &actual[cycle * n];
+                if ((valid >= 0) && !want[valid] && !got[valid]) {
+                    continue;
+                }
+                if (want[i] != got[i]) {
+                    Divergence &divergence = result[i];
+                    if ((divergence.seeds == 0) || (cycle < divergence.first_cycle)) {
+                        divergence.first_cycle = cycle;
+                        divergence.example_seed = seed;
+                        divergence.expected = want[i];
+                        divergence.actual = got[i];
+                    }
+                    divergence.seeds++;
+                    diverged = true;
+                    break;
+                }
+            }
+        }
+        return diverged;
+    }
+
+    static void merge(Divergence &into, const Divergence &from) {
+        if (from.seeds == 0) {
+            return;
+        }
+        if ((into.seeds == 0) || (from.first_cycle < into.first_cycle)) {
+            into.first_cycle = from.first_cycle;
+            into.example_seed = from.example_seed;
+            into.expected = from.expected;
+            into.actual = from.actual;
+        }
+        into.seeds += from.seeds;
+    }
+
+    std::vector<ResetSignal> signals_;
+    uint64_t cycles_;
+    std::vector<Divergence> diverged_;
+    uint64_t seeds_ = 0;
+    uint64_t seeds_diverged_ = 0;
+    unsigned workers_ = 0;
+    double seconds_ = 0.0;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+// Needs the model to be Verilated with --savable
+#include <verilated_save.h>
+
+#include "sim_shard.h"
+
+// Scenarios that start from a saved snapshot of the model.
+//
+// Instead of running every test on one timeline, the harness splits them into
+// scenarios, each of which builds its own model, restores the snapshot named
+// by from, runs, and optionally saves a snapshot of its own. Reset is just the
+// first scenario, starting from a fresh model and saving "reset".
+//
+// A failure in one scenario can't throw off the ones that don't start from
+// it, a scenario can be rerun on its own, and scenarios whose snapshots are
+// ready run in parallel.
+template <typename Fn>
+struct SimScenario {
+    const char *name;
+    // Snapshot to start from, nullptr for a fresh model
+    const char *from;
+    // Snapshot to save at the end, nullptr for none
+    const char *saves;
+    Fn run;
+};
+
+static inline std::string snapshot_path(const char *name) {
+    return std::string{"logs/snapshot_"} + name + ".sav";
+}
+
+static inline bool snapshot_exists(const char *name) {
+    FILE *file = std::fopen(snapshot_path(name).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fclose(file);
+    return true;
+}
+
+template <typename Top>
+void save_snapshot(const char *name, VerilatedContext *contextp, Top *top) {
+    VerilatedSave os;
+    os.open(snapshot_path(name).c_str());
+    // The model doesn't keep the time, the context does
+    uint64_t time = contextp->time();
+    os << time;
+    os << *top;
+    os.close();
+}
+
+template <typename Top>
+void restore_snapshot(const char *name, VerilatedContext *contextp, Top *top) {
+    VerilatedRestore os;
+    os.open(snapshot_path(name).c_str());
+    uint64_t time;
+    os >> time;
+    contextp->time(time);
+    os >> *top;
+    os.close();
+}
+
+// Runs the scenario called only and whatever it needs to get its snapshot, or
+// every scenario if only is nullptr, on up to num_workers threads. run()
+// builds the model for one scenario, runs it and returns true if it passed.
+//
+// Scenarios go in waves: each wave is every scenario whose snapshot has been
+// saved by a scenario that passed. Anything starting from a snapshot that
+// never got saved is skipped.
+//
+// When rerunning one scenario, snapshots left in logs/ by an earlier run are
+// used as they are, so it starts right away.
+//
+// Returns true if everything that was asked for passed.
+template <typename Fn>
+bool run_scenarios(const std::vector<SimScenario<Fn>> &scenarios, const char *only,
+                   unsigned num_workers,
+                   const std::function<bool(const SimScenario<Fn> &scenario)> &run) {
+    enum Result { NOT_RUN, PASSED, FAILED };
+    size_t num_scenarios = scenarios.size();
+
+    auto find_saver = [&scenarios, num_scenarios](const char *snapshot) {
+        for (size_t i = 0; i < num_scenarios; i++) {
+            if ((scenarios[i].saves != nullptr)
+                    && (std::strcmp(scenarios[i].saves, snapshot) == 0)) {
+                return i;
+            }
+        }
+        return num_scenarios;
+    };
+
+    std::vector<bool> wanted(num_scenarios, only == nullptr);
+    std::vector<std::string> ready;
+    if (only != nullptr) {
+        size_t i = 0;
+        while ((i < num_scenarios) && (std::strcmp(scenarios[i].name, only) != 0)) {
+            i++;
+        }
+        if (i == num_scenarios) {
+            VL_PRINTF("No scenario called %s, the scenarios are:\n", only);
+            for (const SimScenario<Fn> &scenario : scenarios) {
+                VL_PRINTF("  %s\n", scenario.name);
+            }
+            return false;
+        }
+
+        // Walk back to the first snapshot we already have
+        while (i < num_scenarios) {
+            wanted[i] = true;
+            const char *from = scenarios[i].from;
+            if (from == nullptr) {
+                break;
+            }
+            if (snapshot_exists(from)) {
+                VL_PRINTF("Reusing %s\n", snapshot_path(from).c_str());
+                ready.push_back(from);
+                break;
+            }
+            i = find_saver(from);
+        }
+    }
+
+    auto is_ready = [&ready](const char *snapshot) {
+        for (const std::string &name : ready) {
+            if (name == snapshot) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    struct ScenarioWorker {};
+    std::vector<Result> results(num_scenarios, NOT_RUN);
+    while (true) {
+        std::vector<size_t> wave;
+        for (size_t i = 0; i < num_scenarios; i++) {
+            if (wanted[i] && (results[i] == NOT_RUN)
+                    && ((scenarios[i].from == nullptr) || is_ready(scenarios[i].from))) {
+                wave.push_back(i);
+            }
+        }
+        if (wave.empty()) {
+            break;
+        }
+
+        run_sharded<ScenarioWorker>(num_workers, wave.size(),
+            [](unsigned) { return std::unique_ptr<ScenarioWorker>{new ScenarioWorker}; },
+            [&](ScenarioWorker &, uint64_t chunk) {
+                size_t i = wave[chunk];
+                results[i] = run(scenarios[i]) ? PASSED : FAILED;
+            });
+
+        for (size_t i : wave) {
+            if ((results[i] == PASSED) && (scenarios[i].saves != nullptr)) {
+                ready.push_back(scenarios[i].saves);
+            }
+        }
+    }
+
+    bool passed = true;
+    VL_PRINTF("\nScenarios:\n");
+    for (size_t i = 0; i < num_scenarios; i++) {
+        if (!wanted[i]) {
+            continue;
+        }
+        const char *result = "skipped";
+        if (results[i] == PASSED) {
+            result = "passed";
+        }
+        else if (results[i] == FAILED) {
+            result = "FAILED";
+        }
+        passed = passed && (results[i] == PASSED);
+        VL_PRINTF("  %-20s %s\n", scenarios[i].name, result);
+    }
+    return passed;
+}
+
+#endif
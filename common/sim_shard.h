@@ -0,0 +1,122 @@
+#ifndef SIM_SHARD_H
+#define SIM_SHARD_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Statistics about how the chunks ended up spread over the workers
+struct ShardStats {
+    unsigned workers = 0;
+    uint64_t chunks = 0;
+    uint64_t stolen = 0;
+};
+
+// Runs num_chunks independent pieces of work on num_workers threads.
+//
+// Every worker builds its own state with make_state() on its own thread
+// (typically a VerilatedContext and a model, which must not be shared between
+// threads) and then calls run_chunk() for each chunk it gets.
+//
+// The chunks are dealt out up front as one contiguous block per worker, which
+// the worker walks from the front. A worker that runs out of chunks steals
+// from the back of another worker's block, so a worker that got slow chunks
+// doesn't leave everyone else waiting on it at the end.
+//
+// Which worker runs a chunk is not deterministic, so run_chunk() should write
+// its results into a slot indexed by the chunk and the caller should merge the
+// slots in chunk order once this returns.
+template <typename State>
+ShardStats run_sharded(unsigned num_workers, uint64_t num_chunks,
+        const std::function<std::unique_ptr<State>(unsigned worker)> &make_state,
+        const std::function<void(State &state, uint64_t chunk)> &run_chunk) {
+    struct ChunkBlock {
+        std::mutex lock;
+        uint64_t next;
+        uint64_t end;
+        uint64_t stolen;
+    };
+
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+    if (num_workers > num_chunks) {
+        num_workers = (num_chunks == 0) ? 1 : (unsigned)num_chunks;
+    }
+
+    std::vector<ChunkBlock> blocks(num_workers);
+    for (unsigned i = 0; i < num_workers; i++) {
+        blocks[i].next = (num_chunks * i) / num_workers;
+        blocks[i].end = (num_chunks * (i + 1)) / num_workers;
+        blocks[i].stolen = 0;
+    }
+
+    auto take_own = [&blocks](unsigned worker, uint64_t &chunk) {
+        ChunkBlock &block = blocks[worker];
+        std::lock_guard<std::mutex> guard{block.lock};
+        if (block.next == block.end) {
+            return false;
+        }
+        chunk = block.next++;
+        return true;
+    };
+
+    auto steal = [&blocks, num_workers](unsigned worker, uint64_t &chunk) {
+        for (unsigned i = 1; i < num_workers; i++) {
+            ChunkBlock &victim = blocks[(worker + i) % num_workers];
+            std::lock_guard<std::mutex> guard{victim.lock};
+            if (victim.next != victim.end) {
+                chunk = --victim.end;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto worker_main = [&](unsigned worker) {
+        std::unique_ptr<State> state = make_state(worker);
+        uint64_t chunk;
+        while (true) {
+            if (take_own(worker, chunk)) {
+                run_chunk(*state, chunk);
+            }
+            else if (steal(worker, chunk)) {
+                run_chunk(*state, chunk);
+                std::lock_guard<std::mutex> guard{blocks[worker].lock};
+                blocks[worker].stolen++;
+            }
+            else {
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_workers; i++) {
+        threads.emplace_back(worker_main, i);
+    }
+    // The calling thread is worker 0
+    worker_main(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    ShardStats stats;
+    stats.workers = num_workers;
+    stats.chunks = num_chunks;
+    for (ChunkBlock &block : blocks) {
+        stats.stolen += block.stolen;
+    }
+    return stats;
+}
+
+// Number of workers to use when the user asked for 0
+static inline unsigned default_shard_count() {
+    unsigned count = std::thread::hardware_concurrency();
+    return (count == 0) ? 1 : count;
+}
+
+#endif
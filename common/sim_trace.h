@@ -0,0 +1,145 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Include common routines
+#include <verilated.h>
+
+#if VM_TRACE_FST
+#include <verilated_fst_c.h>
+#elif VM_TRACE
+#include <verilated_vcd_c.h>
+#endif
+
+#include "sim_args.h"
+#include "sim_clock.h"
+
+// Waveform tracing, controlled from the command line:
+//
+//     +trace                  turn tracing on
+//     +trace_format=fst|vcd   check the model was built with that format
+//     +trace_file=<path>      default logs/vlt_dump.fst or logs/vlt_dump.vcd
+//     +trace_depth=<levels>   levels of hierarchy to trace, default all
+//     +trace_start=<cycle>    first cycle to dump, default 0
+//     +trace_stop=<cycle>     last cycle to dump, default the end of the run
+//
+// The format is picked when the model is verilated (TRACE_FORMAT in the
+// Makefile), since Verilator generates different tracing code for each.
+// FST is compressed, and with --trace-threads the compression and writing
+// happen on a separate thread, so it's much cheaper than VCD on long runs.
+//
+// A harness running several models, one per scenario, gives each a tag which
+// goes on the end of the file name, e.g. logs/vlt_dump_reset.fst.
+//
+// If the model was built without tracing (FLAVOR=fast in the Makefiles) this
+// does nothing, and neither does a model built with it but run without +trace:
+// attach() only adds its observer to the clock when there's a file to dump to.
+template <typename Top>
+class SimTrace {
+  public:
+#if VM_TRACE_FST
+    typedef VerilatedFstC TraceFile;
+    static constexpr const char *format = "fst";
+#elif VM_TRACE
+    typedef VerilatedVcdC TraceFile;
+    static constexpr const char *format = "vcd";
+#else
+    static constexpr const char *format = "none";
+#endif
+
+    SimTrace(VerilatedContext *contextp, Top *top, const SimArgs &args,
+             const char *tag = nullptr)
+        : contextp_{contextp} {
+        if (!args.flag("trace")) {
+            return;
+        }
+
+        std::string wanted = args.str("trace_format", format);
+        if (wanted != format) {
+            VL_PRINTF("Can't trace to %s, the model was built for %s traces. \
+Rebuild with TRACE_FORMAT=%s\n", wanted.c_str(), format, wanted.c_str());
+            return;
+        }
+
+#if VM_TRACE
+        start_cycle_ = args.u64("trace_start", 0);
+        stop_cycle_ = args.u64("trace_stop", UINT64_MAX);
+        std::string default_path = std::string{"logs/vlt_dump."} + format;
+        path_ = args.str("trace_file", default_path.c_str());
+        if (tag != nullptr) {
+            size_t dot = path_.rfind('.');
+            size_t slash = path_.rfind('/');
+            if ((dot == std::string::npos)
+                    || ((slash != std::string::npos) && (dot < slash))) {
+                dot = path_.size();
+            }
+            path_.insert(dot, std::string{"_"} + tag);
+        }
+
+        tfp_.reset(new TraceFile);
+        top->trace(tfp_.get(), (int)args.u64("trace_depth", 99));
+        tfp_->open(path_.c_str());
+        VL_PRINTF("[%" VL_PRI64 "d] Tracing to %s...\n\n", contextp_->time(),
+                  path_.c_str());
+#else
+        (void)top;
+        (void)tag;
+        VL_PRINTF("Can't trace, the model was built without tracing. Rebuild with \
+FLAVOR=debug\n");
+#endif
+    }
+
+    ~SimTrace() {
+        close();
+    }
+
+    SimTrace(const SimTrace &) = delete;
+    SimTrace &operator=(const SimTrace &) = delete;
+
+    // Dumps the current values if cycle is in the window
+    void dump(uint64_t cycle) {
+#if VM_TRACE
+        if (tfp_ && (cycle >= start_cycle_) && (cycle <= stop_cycle_)) {
+            tfp_->dump(contextp_->time());
+        }
+#else
+        (void)cycle;
+#endif
+    }
+
+    // Dump after every evaluation of the clock
+    void attach(SimClock<Top> &sim) {
+#if VM_TRACE
+        if (!tfp_) {
+            return;
+        }
+        SimClock<Top> *simp = &sim;
+        sim.add_observer([this, simp]() { dump(simp->cycles()); });
+#else
+        (void)sim;
+#endif
+    }
+
+    void close() {
+#if VM_TRACE
+        if (tfp_) {
+            tfp_->close();
+            tfp_.reset();
+        }
+#endif
+    }
+
+  private:
+    VerilatedContext *contextp_;
+#if VM_TRACE
+    std::unique_ptr<TraceFile> tfp_;
+    std::string path_;
+    uint64_t start_cycle_ = 0;
+    uint64_t stop_cycle_ = UINT64_MAX;
+#endif
+};
+
+#endif
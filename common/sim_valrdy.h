@@ -0,0 +1,339 @@
+#ifndef SIM_VALRDY_H
+#define SIM_VALRDY_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_clock.h"
+#include "sim_perf.h"
+#include "sim_rand.h"
+
+// Testbench side of val/rdy interfaces.
+//
+// The driver is the producer for one interface and the monitor is the
+// consumer for another. Both are bound to the model's ports with a small port
+// struct the harness writes, for example for the multiplier:
+//
+//     struct MulReqPort {
+//         typedef MulReq Req;
+//         static void drive(Vmultiplier_top *top, bool val, const MulReq &req);
+//         static bool rdy(Vmultiplier_top *top);
+//     };
+//
+//     struct MulRespPort {
+//         typedef uint64_t Resp;
+//         static void set_rdy(Vmultiplier_top *top, bool rdy);
+//         static bool val(Vmultiplier_top *top);
+//         static uint64_t data(Vmultiplier_top *top);
+//         static void report_mismatch(uint64_t time, const uint64_t &expected,
+//                                     const uint64_t &actual);
+//     };
+//
+// Every cycle goes:
+//   1. drive(): the driver puts the head of its queue on the interface, with
+//      val high whenever something is queued, and the monitor sets rdy
+//   2. falling edge: the model settles with the new inputs
+//   3. sample(): both sides check for a handshake, which happens on the
+//      coming rising edge
+//   4. rising edge
+// which is what run_valrdy() does until everything queued has come back.
+//
+// A ValRdyPerf given to run_valrdy() keeps histograms of how long each
+// transaction took from request to response, how long each side waited on the
+// other's rdy, and how many transactions were in flight, see sim_perf.h.
+
+template <typename Top, typename Port>
+class ValRdyDriver {
+  public:
+    typedef typename Port::Req Req;
+
+    explicit ValRdyDriver(Top *top)
+        : top_{top} {}
+
+    void push(const Req &req) { queue_.push_back(req); }
+
+    bool idle() const { return queue_.empty(); }
+    size_t pending() const { return queue_.size(); }
+    uint64_t sent() const { return sent_; }
+    uint64_t stalls() const { return stalls_; }
+
+    // Adds how many cycles each request waited for rdy to hist
+    void record_stalls(SimHistogram *hist) { stall_hist_ = hist; }
+
+    // What went out on the last handshake
+    const Req &last_sent() const { return idle_req_; }
+
+    void drive() {
+        if (queue_.empty()) {
+            Port::drive(top_, false, idle_req_);
+        }
+        else {
+            Port::drive(top_, true, queue_.front());
+        }
+    }
+
+    // Returns true if the head of the queue is taken on the coming edge
+    bool sample() {
+        if (queue_.empty()) {
+            return false;
+        }
+        if (!Port::rdy(top_)) {
+            stalls_++;
+            waited_++;
+            return false;
+        }
+        if (stall_hist_ != nullptr) {
+            stall_hist_->add(waited_);
+        }
+        waited_ = 0;
+        idle_req_ = queue_.front();
+        queue_.pop_front();
+        sent_++;
+        return true;
+    }
+
+  private:
+    Top *top_;
+    std::deque<Req> queue_;
+    // Data stays put when val drops, like most hardware producers
+    Req idle_req_{};
+    uint64_t sent_ = 0;
+    uint64_t stalls_ = 0;
+    // Cycles the head of the queue has waited so far
+    uint64_t waited_ = 0;
+    SimHistogram *stall_hist_ = nullptr;
+};
+
+template <typename Top, typename Port>
+class ValRdyMonitor {
+  public:
+    typedef typename Port::Resp Resp;
+
+    ValRdyMonitor(VerilatedContext *contextp, Top *top)
+        : contextp_{contextp}
+        , top_{top}
+        , rand_{0} {}
+
+    void expect(const Resp &resp) { expected_.push_back(resp); }
+
+    // Drop rdy on average numerator times out of denominator cycles
+    void set_backpressure(uint64_t numerator, uint64_t denominator, uint64_t seed) {
+        stall_numerator_ = numerator;
+        stall_denominator_ = denominator;
+        rand_ = SimRand{seed};
+    }
+
+    // Called on every error, e.g. to trigger the flight recorder
+    void set_error_hook(const std::function<void(const char *reason)> &hook) {
+        error_hook_ = hook;
+    }
+
+    void fail(const char *reason) {
+        errors_++;
+        if (error_hook_) {
+            error_hook_(reason);
+        }
+    }
+
+    bool idle() const { return expected_.empty(); }
+    size_t outstanding() const { return expected_.size(); }
+    uint64_t received() const { return received_; }
+    uint64_t errors() const { return errors_; }
+    uint64_t stalls() const { return stalls_; }
+    // Cycles rdy was high from the first response on, the most responses
+    // that could have been taken in that time
+    uint64_t rdy_cycles() const { return rdy_cycles_; }
+
+    // Adds how many cycles each response waited for rdy to hist
+    void record_stalls(SimHistogram *hist) { stall_hist_ = hist; }
+
+    void drive() {
+        rdy_ = (stall_denominator_ == 0)
+             || !rand_.chance(stall_numerator_, stall_denominator_);
+        Port::set_rdy(top_, rdy_);
+    }
+
+    // Returns true if a response is taken on the coming edge
+    bool sample() {
+        bool val = Port::val(top_);
+        started_ = started_ || val;
+        if (started_ && rdy_) {
+            rdy_cycles_++;
+        }
+        if (!val) {
+            return false;
+        }
+        if (!rdy_) {
+            stalls_++;
+            waited_++;
+            return false;
+        }
+        if (stall_hist_ != nullptr) {
+            stall_hist_->add(waited_);
+        }
+        waited_ = 0;
+        Resp actual = Port::data(top_);
+        if (expected_.empty()) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: unexpected response\n", contextp_->time());
+            fail("unexpected response");
+        }
+        else {
+            if (!(expected_.front() == actual)) {
+                Port::report_mismatch(contextp_->time(), expected_.front(), actual);
+                fail("wrong response");
+            }
+            expected_.pop_front();
+        }
+        received_++;
+        return true;
+    }
+
+  private:
+    VerilatedContext *contextp_;
+    Top *top_;
+    std::deque<Resp> expected_;
+    bool rdy_ = true;
+    uint64_t stall_numerator_ = 0;
+    uint64_t stall_denominator_ = 0;
+    SimRand rand_;
+    std::function<void(const char *reason)> error_hook_;
+    uint64_t received_ = 0;
+    uint64_t errors_ = 0;
+    uint64_t stalls_ = 0;
+    bool started_ = false;
+    uint64_t rdy_cycles_ = 0;
+    // Cycles the response on the interface has waited so far
+    uint64_t waited_ = 0;
+    SimHistogram *stall_hist_ = nullptr;
+};
+
+// Cycle-level performance of a request interface and the response interface
+// it's paired with. run_valrdy() fills it in, or a harness with its own loop
+// calls attach() once and cycle() every cycle.
+class ValRdyPerf {
+  public:
+    // Cycles from each request's handshake to its response's
+    SimHistogram latency;
+    // Cycles each request and each response waited with val high for rdy
+    SimHistogram req_stall;
+    SimHistogram resp_stall;
+    // Requests taken but not answered yet, after each edge
+    SimHistogram occupancy;
+
+    template <typename Top, typename ReqPort, typename RespPort>
+    void attach(ValRdyDriver<Top, ReqPort> &driver,
+                ValRdyMonitor<Top, RespPort> &monitor) {
+        driver.record_stalls(&req_stall);
+        monitor.record_stalls(&resp_stall);
+    }
+
+    // sent and received are whether each side had a handshake on the edge.
+    // Responses come back in order, so each one goes with the oldest request
+    void cycle(bool sent, bool received) {
+        if (sent) {
+            in_flight_.push_back(cycles_);
+        }
+        // An unexpected response has no request to go with
+        if (received && !in_flight_.empty()) {
+            latency.add(cycles_ - in_flight_.front());
+            in_flight_.pop_front();
+        }
+        occupancy.add(in_flight_.size());
+        cycles_++;
+    }
+
+    uint64_t cycles() const { return cycles_; }
+
+    // Throughput and the percentiles of each histogram, and with histograms
+    // every bucket of them too
+    void report(const char *name, bool histograms) const {
+        VL_PRINTF("%s: %" VL_PRI64 "u transactions in %" VL_PRI64 "u cycles, \
+%.3f per cycle\n",
+                name, latency.count(), cycles_,
+                (cycles_ == 0) ? 0.0 : (double)latency.count() / (double)cycles_);
+        latency.report("latency");
+        req_stall.report("request stall");
+        resp_stall.report("response stall");
+        occupancy.report("in flight");
+        if (histograms) {
+            latency.print("latency");
+            req_stall.print("request stall");
+            resp_stall.print("response stall");
+            occupancy.print("in flight");
+        }
+    }
+
+  private:
+    // The cycle each request in flight was taken on
+    std::deque<uint64_t> in_flight_;
+    uint64_t cycles_ = 0;
+};
+
+// Result of one run_valrdy() call
+struct ValRdyRun {
+    uint64_t cycles = 0;
+    uint64_t transactions = 0;
+    // Cycles the monitor's rdy was high, see ValRdyMonitor::rdy_cycles()
+    uint64_t rdy_cycles = 0;
+    bool timed_out = false;
+
+    double per_cycle() const {
+        return (cycles == 0) ? 0.0 : (double)transactions / (double)cycles;
+    }
+};
+
+// Runs the clock until the driver has sent everything and the monitor has
+// received everything it expects, or until nothing has moved on either side
+// for timeout_cycles. Must be called right after a rising edge, which is also
+// where it leaves the clock. Adds what it sees to perf, if given.
+template <typename Top, typename ReqPort, typename RespPort>
+ValRdyRun run_valrdy(SimClock<Top> &sim,
+                     ValRdyDriver<Top, ReqPort> &driver,
+                     ValRdyMonitor<Top, RespPort> &monitor,
+                     uint64_t timeout_cycles,
+                     ValRdyPerf *perf = nullptr) {
+    ValRdyRun run;
+    if (perf != nullptr) {
+        perf->attach(driver, monitor);
+    }
+    uint64_t idle_cycles = 0;
+    uint64_t start_received = monitor.received();
+    uint64_t start_rdy_cycles = monitor.rdy_cycles();
+
+    while (!driver.idle() || !monitor.idle()) {
+        driver.drive();
+        monitor.drive();
+        sim.half_cycle();
+
+        bool sent = driver.sample();
+        bool received = monitor.sample();
+        bool progress = sent || received;
+        if (perf != nullptr) {
+            perf->cycle(sent, received);
+        }
+        sim.half_cycle();
+        run.cycles++;
+
+        idle_cycles = progress ? 0 : idle_cycles + 1;
+        if (idle_cycles == timeout_cycles) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: val/rdy timed out with %zu requests \
+pending and %zu responses outstanding\n",
+                    sim.contextp()->time(), driver.pending(), monitor.outstanding());
+            run.timed_out = true;
+            monitor.fail("val/rdy timed out");
+            break;
+        }
+    }
+    // Let go of the interface
+    driver.drive();
+
+    run.transactions = monitor.received() - start_received;
+    run.rdy_cycles = monitor.rdy_cycles() - start_rdy_cycles;
+    return run;
+}
+
+#endif
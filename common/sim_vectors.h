@@ -0,0 +1,559 @@
+#ifndef SIM_VECTORS_H
+#define SIM_VECTORS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// For mmap
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_clock.h"
+
+// Recorded stimulus and expected outputs.
+//
+// A vector file holds, cycle by cycle, the values to drive on the model's
+// inputs, the outputs expected after the rising edge, and a mask of the output
+// bits that matter. VecRecorder writes one from any run of the harness, and
+// the harness can replay it later, or hand-edited or generated ones, without
+// being rebuilt.
+//
+// Every record is the same number of 64 bit words, so the replay maps the file
+// into memory and reads the records where they are, with no parsing. The first
+// word of a record is how many cycles it lasts, so long stretches where
+// nothing changes take one record. The signal values follow, packed at fixed
+// bit offsets: inputs, expected outputs, then masks.
+//
+// The file starts with a header:
+//     magic           8 bytes, "SIMVEC" 0 1
+//     num_inputs      uint32_t
+//     num_outputs     uint32_t
+//     record_words    uint32_t
+//     reserved        uint32_t
+//     num_records     uint64_t
+//     records_offset  uint64_t, where the records start, a multiple of 8
+//     signals         inputs then outputs, each a uint32_t width and a name
+//     start           the snapshot the recording started from, "" for reset
+// where each name is a uint32_t length and that many characters.
+
+static const char sim_vectors_magic[8] = {'S', 'I', 'M', 'V', 'E', 'C', 0, 1};
+
+struct VecSignal {
+    const char *name;
+    unsigned width;
+};
+
+// How the harness's ports map onto a vector file. The functions take one value
+// per signal, in the order of the lists
+template <typename Top>
+struct VecBinding {
+    std::vector<VecSignal> inputs;
+    std::vector<VecSignal> outputs;
+    // Sets the inputs
+    void (*drive)(Top *top, const uint64_t *inputs);
+    // Reads back what's on the inputs, for recording
+    void (*read_inputs)(const Top *top, uint64_t *inputs);
+    // Reads the outputs
+    void (*sample)(const Top *top, uint64_t *outputs);
+    // Reads every state register, packed into one value, for fast-forward.
+    // nullptr if the harness can't see them
+    uint64_t (*state)(const Top *top);
+};
+
+// Where each field of a record goes. A field never straddles two words
+class VecLayout {
+  public:
+    VecLayout() {}
+
+    VecLayout(const std::vector<unsigned> &input_widths,
+              const std::vector<unsigned> &output_widths) {
+        unsigned word = 1;
+        unsigned bit = 0;
+        auto place = [&word, &bit](unsigned width, std::vector<VecField> &fields) {
+            if (bit + width > 64) {
+                word++;
+                bit = 0;
+            }
+            fields.push_back({word, bit, width});
+            bit += width;
+        };
+        for (unsigned width : input_widths) {
+            place(width, inputs_);
+        }
+        for (unsigned width : output_widths) {
+            place(width, expected_);
+        }
+        for (unsigned width : output_widths) {
+            place(width, masks_);
+        }
+        words_ = (bit == 0) ? word : word + 1;
+    }
+
+    unsigned words() const { return words_; }
+
+    static uint64_t repeat(const uint64_t *record) { return record[0]; }
+
+    void unpack_inputs(const uint64_t *record, uint64_t *values) const {
+        unpack(inputs_, record, values);
+    }
+    void unpack_expected(const uint64_t *record, uint64_t *values) const {
+        unpack(expected_, record, values);
+    }
+    void unpack_masks(const uint64_t *record, uint64_t *values) const {
+        unpack(masks_, record, values);
+    }
+
+    void pack(uint64_t *record, uint64_t repeat, const uint64_t *inputs,
+              const uint64_t *expected, const uint64_t *masks) const {
+        std::memset(record, 0, words_ * sizeof(uint64_t));
+        record[0] = repeat;
+        pack(inputs_, record, inputs);
+        pack(expected_, record, expected);
+        pack(masks_, record, masks);
+    }
+
+  private:
+    struct VecField {
+        unsigned word;
+        unsigned bit;
+        unsigned width;
+
+        uint64_t mask() const {
+            return (width >= 64) ? ~0ULL : ((1ULL << width) - 1);
+        }
+    };
+
+    static void unpack(const std::vector<VecField> &fields, const uint64_t *record,
+                       uint64_t *values) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            values[i] = (record[fields[i].word] >> fields[i].bit) & fields[i].mask();
+        }
+    }
+
+    static void pack(const std::vector<VecField> &fields, uint64_t *record,
+                     const uint64_t *values) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            record[fields[i].word] |= (values[i] & fields[i].mask()) << fields[i].bit;
+        }
+    }
+
+    std::vector<VecField> inputs_;
+    std::vector<VecField> expected_;
+    std::vector<VecField> masks_;
+    unsigned words_ = 1;
+};
+
+template <typename Top>
+VecLayout vec_layout(const VecBinding<Top> &binding) {
+    std::vector<unsigned> input_widths;
+    std::vector<unsigned> output_widths;
+    for (const VecSignal &signal : binding.inputs) {
+        input_widths.push_back(signal.width);
+    }
+    for (const VecSignal &signal : binding.outputs) {
+        output_widths.push_back(signal.width);
+    }
+    return VecLayout{input_widths, output_widths};
+}
+
+// Records the ports on every rising edge of the SimClock: the inputs the edge
+// saw and the outputs it produced, with every output bit cared about. Cycles
+// that are the same as the one before are merged into one record.
+template <typename Top>
+class VecRecorder {
+  public:
+    // start is the snapshot the model was restored from, nullptr for reset
+    VecRecorder(SimClock<Top> &sim, const VecBinding<Top> &binding,
+                const std::string &path, const char *start = nullptr)
+        : top_{sim.top()}
+        , binding_{binding}
+        , layout_{vec_layout(binding)}
+        , path_{path}
+        , last_clk_{sim.top()->clk != 0}
+        , inputs_(binding.inputs.size())
+        , outputs_(binding.outputs.size())
+        , masks_(binding.outputs.size())
+        , record_(layout_.words())
+        , pending_(layout_.words()) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_ == nullptr) {
+            VL_PRINTF("Can't open %s, not recording vectors\n", path.c_str());
+            return;
+        }
+        write_header(start);
+        for (size_t i = 0; i < binding.outputs.size(); i++) {
+            unsigned width = binding.outputs[i].width;
+            masks_[i] = (width >= 64) ? ~0ULL : ((1ULL << width) - 1);
+        }
+        sim.add_observer([this]() { sample(); });
+    }
+
+    ~VecRecorder() {
+        close();
+    }
+
+    VecRecorder(const VecRecorder &) = delete;
+    VecRecorder &operator=(const VecRecorder &) = delete;
+
+    void close() {
+        if (file_ == nullptr) {
+            return;
+        }
+        flush();
+        // Now the number of records is known
+        std::fseek(file_, num_records_offset_, SEEK_SET);
+        std::fwrite(&num_records_, sizeof(num_records_), 1, file_);
+        std::fclose(file_);
+        file_ = nullptr;
+        VL_PRINTF("Recorded %" VL_PRI64 "u cycles as %" VL_PRI64 "u vectors to %s\n",
+                cycles_, num_records_, path_.c_str());
+    }
+
+  private:
+    void write_string(const char *str) {
+        uint32_t len = (uint32_t)std::strlen(str);
+        std::fwrite(&len, sizeof(len), 1, file_);
+        std::fwrite(str, 1, len, file_);
+    }
+
+    void write_header(const char *start) {
+        std::fwrite(sim_vectors_magic, sizeof(sim_vectors_magic), 1, file_);
+        uint32_t counts[4] = {(uint32_t)binding_.inputs.size(),
+                              (uint32_t)binding_.outputs.size(), layout_.words(), 0};
+        std::fwrite(counts, sizeof(counts), 1, file_);
+        num_records_offset_ = std::ftell(file_);
+        uint64_t offsets[2] = {0, 0};
+        std::fwrite(offsets, sizeof(offsets), 1, file_);
+        for (const std::vector<VecSignal> *signals : {&binding_.inputs, &binding_.outputs}) {
+            for (const VecSignal &signal : *signals) {
+                uint32_t width = signal.width;
+                std::fwrite(&width, sizeof(width), 1, file_);
+                write_string(signal.name);
+            }
+        }
+        write_string((start != nullptr) ? start : "");
+
+        // Line the records up on 8 bytes so they can be read in place
+        long offset = std::ftell(file_);
+        while (offset % 8 != 0) {
+            std::fputc(0, file_);
+            offset++;
+        }
+        uint64_t records_offset = offset;
+        std::fseek(file_, num_records_offset_ + sizeof(uint64_t), SEEK_SET);
+        std::fwrite(&records_offset, sizeof(records_offset), 1, file_);
+        std::fseek(file_, offset, SEEK_SET);
+    }
+
+    void sample() {
+        bool rising = top_->clk && !last_clk_;
+        last_clk_ = top_->clk;
+        if (!rising || (file_ == nullptr)) {
+            return;
+        }
+        cycles_++;
+
+        binding_.sample(top_, outputs_.data());
+        // The inputs are still what the testbench drove for this edge
+        binding_.read_inputs(top_, inputs_.data());
+        layout_.pack(record_.data(), 1, inputs_.data(), outputs_.data(), masks_.data());
+
+        if (pending_[0] != 0) {
+            if (std::memcmp(&record_[1], &pending_[1],
+                            (record_.size() - 1) * sizeof(uint64_t)) == 0) {
+                pending_[0]++;
+                return;
+            }
+            flush();
+        }
+        pending_ = record_;
+    }
+
+    void flush() {
+        if (pending_[0] == 0) {
+            return;
+        }
+        std::fwrite(pending_.data(), sizeof(uint64_t), pending_.size(), file_);
+        num_records_++;
+        pending_[0] = 0;
+    }
+
+    Top *top_;
+    VecBinding<Top> binding_;
+    VecLayout layout_;
+    std::string path_;
+    FILE *file_ = nullptr;
+    long num_records_offset_ = 0;
+    bool last_clk_;
+
+    std::vector<uint64_t> inputs_;
+    std::vector<uint64_t> outputs_;
+    std::vector<uint64_t> masks_;
+    std::vector<uint64_t> record_;
+    // The record being added to, repeat 0 if there isn't one
+    std::vector<uint64_t> pending_;
+    uint64_t num_records_ = 0;
+    uint64_t cycles_ = 0;
+};
+
+// A vector file, mapped into memory
+class VecFile {
+  public:
+    explicit VecFile(const std::string &path)
+        : path_{path} {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            VL_PRINTF("Can't open %s\n", path.c_str());
+            return;
+        }
+        struct stat info;
+        if ((::fstat(fd, &info) == 0) && (info.st_size > 0)) {
+            void *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = (const uint8_t *)data;
+                size_ = info.st_size;
+                // The records are read front to back, once
+                ::madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (data_ == nullptr) {
+            VL_PRINTF("Can't map %s\n", path.c_str());
+            return;
+        }
+        valid_ = read_header();
+    }
+
+    ~VecFile() {
+        if (data_ != nullptr) {
+            ::munmap((void *)data_, size_);
+        }
+    }
+
+    VecFile(const VecFile &) = delete;
+    VecFile &operator=(const VecFile &) = delete;
+
+    bool valid() const { return valid_; }
+    const std::string &path() const { return path_; }
+    // The snapshot to restore before replaying, nullptr to start from reset
+    const char *start() const { return start_.empty() ? nullptr : start_.c_str(); }
+
+    uint64_t num_records() const { return num_records_; }
+    const VecLayout &layout() const { return layout_; }
+    const uint64_t *record(uint64_t i) const {
+        return records_ + i * layout_.words();
+    }
+
+    // True if the file's signals are the binding's, in the same order and
+    // with the same widths
+    template <typename Top>
+    bool matches(const VecBinding<Top> &binding) const {
+        if ((inputs_.size() != binding.inputs.size())
+                || (outputs_.size() != binding.outputs.size())) {
+            VL_PRINTF("%s has %zu inputs and %zu outputs, the harness has %zu and %zu\n",
+                    path_.c_str(), inputs_.size(), outputs_.size(), binding.inputs.size(),
+                    binding.outputs.size());
+            return false;
+        }
+        return matches(inputs_, binding.inputs) && matches(outputs_, binding.outputs);
+    }
+
+  private:
+    struct FileSignal {
+        std::string name;
+        unsigned width;
+    };
+
+    bool matches(const std::vector<FileSignal> &file_signals,
+                 const std::vector<VecSignal> &signals) const {
+        for (size_t i = 0; i < signals.size(); i++) {
+            if ((file_signals[i].name != signals[i].name)
+                    || (file_signals[i].width != signals[i].width)) {
+                VL_PRINTF("%s has signal %s[%u] where the harness has %s[%u]\n",
+                        path_.c_str(), file_signals[i].name.c_str(), file_signals[i].width,
+                        signals[i].name, signals[i].width);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool read(void *out, size_t len) {
+        if (offset_ + len > size_) {
+            return false;
+        }
+        std::memcpy(out, data_ + offset_, len);
+        offset_ += len;
+        return true;
+    }
+
+    bool read_string(std::string &str) {
+        uint32_t len;
+        if (!read(&len, sizeof(len)) || (offset_ + len > size_)) {
+            return false;
+        }
+        str.assign((const char *)data_ + offset_, len);
+        offset_ += len;
+        return true;
+    }
+
+    bool read_header() {
+        char magic[8];
+        uint32_t counts[4];
+        uint64_t offsets[2];
+        if (!read(magic, sizeof(magic)) || (std::memcmp(magic, sim_vectors_magic,
+                                                        sizeof(magic)) != 0)) {
+            VL_PRINTF("%s isn't a vector file\n", path_.c_str());
+            return false;
+        }
+        if (!read(counts, sizeof(counts)) || !read(offsets, sizeof(offsets))) {
+            VL_PRINTF("%s is cut short\n", path_.c_str());
+            return false;
+        }
+
+        std::vector<unsigned> input_widths;
+        std::vector<unsigned> output_widths;
+        for (uint32_t i = 0; i < counts[0] + counts[1]; i++) {
+            FileSignal signal;
+            uint32_t width;
+            if (!read(&width, sizeof(width)) || !read_string(signal.name)) {
+                VL_PRINTF("%s is cut short\n", path_.c_str());
+                return false;
+            }
+            signal.width = width;
+            if (i < counts[0]) {
+                inputs_.push_back(signal);
+                input_widths.push_back(width);
+            }
+            else {
+                outputs_.push_back(signal);
+                output_widths.push_back(width);
+            }
+        }
+        if (!read_string(start_)) {
+            VL_PRINTF("%s is cut short\n", path_.c_str());
+            return false;
+        }
+
+        layout_ = VecLayout{input_widths, output_widths};
+        num_records_ = offsets[0];
+        uint64_t records_offset = offsets[1];
+        if ((layout_.words() != counts[2]) || (records_offset % 8 != 0)
+                || (records_offset + num_records_ * layout_.words() * sizeof(uint64_t)
+                    > size_)) {
+            VL_PRINTF("%s doesn't hold the records its header says it does\n",
+                    path_.c_str());
+            return false;
+        }
+        records_ = (const uint64_t *)(data_ + records_offset);
+        return true;
+    }
+
+    std::string path_;
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    bool valid_ = false;
+
+    std::vector<FileSignal> inputs_;
+    std::vector<FileSignal> outputs_;
+    std::string start_;
+    VecLayout layout_;
+    uint64_t num_records_ = 0;
+    const uint64_t *records_ = nullptr;
+};
+
+struct VecReplay {
+    uint64_t records = 0;
+    // Including the skipped ones
+    uint64_t cycles = 0;
+    uint64_t skipped = 0;
+    uint64_t errors = 0;
+};
+
+// Drives every record of the file onto the model and checks the outputs after
+// each rising edge. Prints the first max_reported mismatches and calls
+// on_error, if given, for every one. Leaves the clock where it started, just
+// after a falling edge.
+//
+// With fast_forward, once a cycle of a record leaves the state as it found it
+// and the outputs right, the rest of the record's cycles can't be any
+// different, so they're skipped with SimClock::skip_cycles(). Needs the
+// binding's state function.
+template <typename Top>
+VecReplay replay_vectors(SimClock<Top> &sim, const VecBinding<Top> &binding,
+                         const VecFile &file, uint64_t max_reported,
+                         const std::function<void(const char *reason)> &on_error = nullptr,
+                         bool fast_forward = false) {
+    VecReplay replay;
+    Top *top = sim.top();
+    const VecLayout &layout = file.layout();
+    size_t num_outputs = binding.outputs.size();
+    std::vector<uint64_t> inputs(binding.inputs.size());
+    std::vector<uint64_t> expected(num_outputs);
+    std::vector<uint64_t> masks(num_outputs);
+    std::vector<uint64_t> actual(num_outputs);
+
+    // Records are lined up on rising edges
+    if (top->clk) {
+        sim.half_cycle();
+    }
+
+    for (uint64_t i = 0; i < file.num_records(); i++) {
+        const uint64_t *record = file.record(i);
+        layout.unpack_inputs(record, inputs.data());
+        layout.unpack_expected(record, expected.data());
+        layout.unpack_masks(record, masks.data());
+        binding.drive(top, inputs.data());
+
+        uint64_t repeat = VecLayout::repeat(record);
+        for (uint64_t cycle = 0; cycle < repeat; cycle++) {
+            uint64_t state = fast_forward ? binding.state(top) : 0;
+            bool matched = true;
+            sim.half_cycle();
+            binding.sample(top, actual.data());
+            for (size_t output = 0; output < num_outputs; output++) {
+                if (((actual[output] ^ expected[output]) & masks[output]) == 0) {
+                    continue;
+                }
+                matched = false;
+                replay.errors++;
+                if (replay.errors <= max_reported) {
+                    VL_PRINTF("[%" VL_PRI64 "d] ERROR: vector %" VL_PRI64 "u %s wrong. \
+Expected: %" VL_PRI64 "x, Actual: %" VL_PRI64 "x, Mask: %" VL_PRI64 "x\n",
+                            sim.contextp()->time(), i, binding.outputs[output].name,
+                            expected[output], actual[output], masks[output]);
+                }
+                if (on_error) {
+                    on_error("vector mismatch");
+                }
+            }
+            sim.half_cycle();
+            replay.cycles++;
+
+            if (fast_forward && matched && (binding.state(top) == state)) {
+                uint64_t rest = repeat - cycle - 1;
+                sim.skip_cycles(rest);
+                replay.cycles += rest;
+                replay.skipped += rest;
+                break;
+            }
+        }
+        replay.records++;
+    }
+    if (replay.errors > max_reported) {
+        VL_PRINTF("... and %" VL_PRI64 "u more mismatches\n", replay.errors - max_reported);
+    }
+    return replay;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef SIM_WATCHDOG_H
+#define SIM_WATCHDOG_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_clock.h"
+#include "sim_flight.h"
+
+// Hang detection.
+//
+// A design that never raises rdy or val leaves a harness waiting on it
+// spinning forever, and the regression with it. The watchdog watches the
+// model's val/rdy interfaces after every evaluation of the SimClock, and when
+// no interface has had a handshake for limit cycles, it gives up on the run:
+//   1. prints every interface with how long it's been since its last
+//      handshake, and how long its val has been waiting on rdy
+//   2. prints the value of every port, from the same signals and sample
+//      function as the flight recorder
+//   3. with a window, writes the last window cycles of the ports to
+//      <prefix>_0.vcd
+//   4. calls the harness's hang hook, to close the trace and the event log
+//   5. exits with SIM_WATCHDOG_EXIT
+//
+// The limit has to be longer than anything the design may legitimately take,
+// and longer than any stretch where the harness deliberately does nothing.
+
+// Same as timeout(1), so a script can treat both the same way
+#define SIM_WATCHDOG_EXIT 124
+
+// A val/rdy interface the watchdog watches
+template <typename Top>
+struct WatchPort {
+    const char *name;
+    bool (*val)(const Top *top);
+    bool (*rdy)(const Top *top);
+};
+
+template <typename Top>
+class SimWatchdog {
+  public:
+    typedef typename FlightRecorder<Top>::SampleFn SampleFn;
+
+    // window is how many cycles to dump on a hang, 0 for none
+    SimWatchdog(SimClock<Top> &sim, const std::vector<WatchPort<Top>> &ports,
+                const std::vector<FlightSignal> &signals, SampleFn sample,
+                uint64_t limit, uint64_t window, const std::string &prefix)
+        : sim_(sim)
+        , ports_{ports}
+        , signals_{signals}
+        , sample_{sample}
+        , limit_{limit}
+        , last_handshake_(ports.size(), 0)
+        , seen_(ports.size(), false)
+        , waiting_since_(ports.size(), 0)
+        , waiting_(ports.size(), false)
+        , last_progress_{sim.cycles()} {
+        if (window != 0) {
+            window_.reset(new FlightRecorder<Top>{sim, signals, sample, window, 0, prefix, 1});
+        }
+        sim.add_observer([this]() { check(); });
+    }
+
+    // Called on a hang, just before exiting
+    void set_hang_hook(const std::function<void()> &hook) { hang_hook_ = hook; }
+
+    // Gives up on the run straight away, for harness checks that know it's hung
+    void hang(const char *reason) {
+        uint64_t now = sim_.cycles();
+        VL_PRINTF("[%" VL_PRI64 "d] ERROR: watchdog: %s\n", sim_.contextp()->time(), reason);
+        const Top *top = sim_.top();
+        for (size_t i = 0; i < ports_.size(); i++) {
+            std::string state = "last handshake ";
+            state += seen_[i] ? std::to_string(now - last_handshake_[i]) + " cycles ago"
+                              : "never";
+            if (waiting_[i]) {
+                state += ", val waiting on rdy for "
+                       + std::to_string(now - waiting_since_[i]) + " cycles";
+            }
+            VL_PRINTF("  %-12s val %d rdy %d, %s\n", ports_[i].name, ports_[i].val(top),
+                    ports_[i].rdy(top), state.c_str());
+        }
+
+        std::vector<uint64_t> values(signals_.size());
+        sample_(sim_.top(), values.data());
+        VL_PRINTF("  Ports:\n");
+        for (size_t i = 0; i < signals_.size(); i++) {
+            VL_PRINTF("    %-16s %" VL_PRI64 "x\n", signals_[i].name, values[i]);
+        }
+
+        if (window_) {
+            window_->trigger(reason);
+            window_->finish();
+        }
+        if (hang_hook_) {
+            hang_hook_();
+        }
+        std::exit(SIM_WATCHDOG_EXIT);
+    }
+
+  private:
+    void check() {
+        const Top *top = sim_.top();
+        uint64_t now = sim_.cycles();
+        for (size_t i = 0; i < ports_.size(); i++) {
+            bool val = ports_[i].val(top);
+            bool rdy = ports_[i].rdy(top);
+            if (val && rdy) {
+                last_handshake_[i] = now;
+                seen_[i] = true;
+                last_progress_ = now;
+            }
+            if (val && !rdy && !waiting_[i]) {
+                waiting_since_[i] = now;
+            }
+            waiting_[i] = val && !rdy;
+        }
+
+        if (now - last_progress_ >= limit_) {
+            hang(("no handshake on any interface for "
+                  + std::to_string(now - last_progress_) + " cycles").c_str());
+        }
+    }
+
+    SimClock<Top> &sim_;
+    std::vector<WatchPort<Top>> ports_;
+    std::vector<FlightSignal> signals_;
+    SampleFn sample_;
+    uint64_t limit_;
+    std::unique_ptr<FlightRecorder<Top>> window_;
+    std::function<void()> hang_hook_;
+
+    // Per interface: the cycle of its last handshake, whether it's had one at
+    // all, and since when its producer has been waiting on rdy
+    std::vector<uint64_t> last_handshake_;
+    std::vector<bool> seen_;
+    std::vector<uint64_t> waiting_since_;
+    std::vector<bool> waiting_;
+    uint64_t last_progress_;
+};
+
+#endif
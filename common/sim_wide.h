@@ -0,0 +1,295 @@
+#ifndef SIM_WIDE_H
+#define SIM_WIDE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+#include "sim_rand.h"
+
+// Unsigned numbers of any width, for ports wider than 64 bits.
+//
+// The words are 32 bits, least significant first, which is how Verilator lays
+// out a VlWide port, so going between the two is a copy. Ports of up to 64 bits
+// are plain integers in Verilator and take the low words.
+template <size_t Words>
+struct WideUint {
+    uint32_t words[Words];
+
+    WideUint()
+        : words{} {}
+
+    WideUint(uint64_t value)
+        : words{} {
+        words[0] = (uint32_t)value;
+        if (Words > 1) {
+            words[1] = (uint32_t)(value >> 32);
+        }
+    }
+
+    uint64_t low64() const {
+        uint64_t value = words[0];
+        if (Words > 1) {
+            value |= (uint64_t)words[1] << 32;
+        }
+        return value;
+    }
+
+    bool operator==(const WideUint &other) const {
+        for (size_t i = 0; i < Words; i++) {
+            if (words[i] != other.words[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const WideUint &other) const {
+        return !(*this == other);
+    }
+
+    // Bits lsb up to lsb + width - 1, at most 64 of them, e.g. one port's
+    // worth of a packed array of ports
+    uint64_t field(unsigned lsb, unsigned width) const {
+        uint64_t value = 0;
+        for (unsigned done = 0; done < width;) {
+            unsigned bit = lsb + done;
+            unsigned shift = bit % 32;
+            unsigned take = (32 - shift < width - done) ? 32 - shift : width - done;
+            uint64_t chunk = words[bit / 32] >> shift;
+            chunk &= (take == 32) ? 0xffffffffULL : ((1ULL << take) - 1);
+            value |= chunk << done;
+            done += take;
+        }
+        return value;
+    }
+
+    void set_field(unsigned lsb, unsigned width, uint64_t value) {
+        for (unsigned done = 0; done < width;) {
+            unsigned bit = lsb + done;
+            unsigned shift = bit % 32;
+            unsigned take = (32 - shift < width - done) ? 32 - shift : width - done;
+            uint32_t mask = (take == 32) ? 0xffffffffU : (((1U << take) - 1) << shift);
+            words[bit / 32] = (words[bit / 32] & ~mask)
+                            | ((uint32_t)((value >> done) << shift) & mask);
+            done += take;
+        }
+    }
+
+    // Clears everything from bit width up
+    void mask(unsigned width) {
+        for (size_t i = 0; i < Words; i++) {
+            if (width <= 32 * i) {
+                words[i] = 0;
+            }
+            else if (width < 32 * (i + 1)) {
+                words[i] &= (1U << (width - 32 * i)) - 1;
+            }
+        }
+    }
+
+    std::string hex() const {
+        std::string text;
+        char word[16];
+        for (size_t i = Words; i-- > 0;) {
+            if (text.empty() && (words[i] == 0) && (i != 0)) {
+                continue;
+            }
+            std::snprintf(word, sizeof(word), text.empty() ? "%x" : "%08x", words[i]);
+            text += word;
+        }
+        return text;
+    }
+};
+
+template <size_t Words, typename Port>
+void wide_to_port(Port &port, const WideUint<Words> &value) {
+    port = (Port)value.low64();
+}
+
+template <size_t Words, size_t PortWords>
+void wide_to_port(VlWide<PortWords> &port, const WideUint<Words> &value) {
+    for (size_t i = 0; i < PortWords; i++) {
+        port[i] = (i < Words) ? value.words[i] : 0;
+    }
+}
+
+template <size_t Words, typename Port>
+WideUint<Words> wide_from_port(const Port &port) {
+    return WideUint<Words>{(uint64_t)port};
+}
+
+template <size_t Words, size_t PortWords>
+WideUint<Words> wide_from_port(const VlWide<PortWords> &port) {
+    WideUint<Words> value;
+    for (size_t i = 0; (i < Words) && (i < PortWords); i++) {
+        value.words[i] = port[i];
+    }
+    return value;
+}
+
+template <size_t Words>
+WideUint<Words> wide_random(SimRand &rand, unsigned width) {
+    WideUint<Words> value;
+    for (size_t i = 0; i < Words; i += 2) {
+        uint64_t bits = rand.next();
+        value.words[i] = (uint32_t)bits;
+        if (i + 1 < Words) {
+            value.words[i + 1] = (uint32_t)(bits >> 32);
+        }
+    }
+    value.mask(width);
+    return value;
+}
+
+// Values that tend to break arithmetic: zero, one, all ones, the top bit,
+// alternating bits, and both sides of every word boundary, where carries
+// have to cross between words
+template <size_t Words>
+std::vector<WideUint<Words>> wide_corners(unsigned width) {
+    std::vector<WideUint<Words>> corners;
+    WideUint<Words> ones;
+    WideUint<Words> fives;
+    WideUint<Words> tens;
+    for (size_t i = 0; i < Words; i++) {
+        ones.words[i] = 0xffffffff;
+        fives.words[i] = 0x55555555;
+        tens.words[i] = 0xaaaaaaaa;
+    }
+
+    corners.push_back(WideUint<Words>{0});
+    corners.push_back(WideUint<Words>{1});
+    corners.push_back(WideUint<Words>{2});
+    corners.push_back(ones);
+    WideUint<Words> ones_but_low = ones;
+    ones_but_low.words[0] &= ~1U;
+    corners.push_back(ones_but_low);
+    WideUint<Words> top;
+    top.words[(width - 1) / 32] = 1U << ((width - 1) % 32);
+    corners.push_back(top);
+    corners.push_back(fives);
+    corners.push_back(tens);
+    for (unsigned bit = 32; bit < width; bit += 32) {
+        WideUint<Words> boundary;
+        boundary.words[bit / 32] = 1;
+        corners.push_back(boundary);
+        WideUint<Words> below;
+        for (unsigned i = 0; i < bit / 32; i++) {
+            below.words[i] = 0xffffffff;
+        }
+        corners.push_back(below);
+    }
+
+    for (WideUint<Words> &corner : corners) {
+        corner.mask(width);
+    }
+    return corners;
+}
+
+// Multiplies pairs of Words word numbers into 2 * Words word products, a batch
+// at a time.
+//
+// The batch is stored a word at a time, all of the first words, then all of
+// the second words and so on, so every inner loop does the same thing to
+// consecutive elements and the compiler can vectorize it. The partial
+// products are added up in 64 bit columns without carrying, then the carries
+// go through in one pass at the end. Each column gets at most 2 * Words
+// halves of 32 bits plus a carry, so it can't overflow.
+template <size_t Words>
+class WideMulBatch {
+  public:
+    static const size_t product_words = 2 * Words;
+
+    explicit WideMulBatch(size_t capacity)
+        : capacity_{capacity}
+        , a_(Words * capacity)
+        , b_(Words * capacity)
+        , columns_(product_words * capacity)
+        , product_(product_words * capacity) {}
+
+    size_t capacity() const { return capacity_; }
+
+    void set(size_t i, const WideUint<Words> &a, const WideUint<Words> &b) {
+        for (size_t word = 0; word < Words; word++) {
+            a_[word * capacity_ + i] = a.words[word];
+            b_[word * capacity_ + i] = b.words[word];
+        }
+    }
+
+    // Multiplies the first count pairs
+    void run(size_t count) {
+        for (size_t column = 0; column < product_words; column++) {
+            uint64_t *sum = &columns_[column * capacity_];
+            for (size_t i = 0; i < count; i++) {
+                sum[i] = 0;
+            }
+        }
+
+        for (size_t j = 0; j < Words; j++) {
+            const uint32_t *a = &a_[j * capacity_];
+            for (size_t k = 0; k < Words; k++) {
+                const uint32_t *b = &b_[k * capacity_];
+                uint64_t *low = &columns_[(j + k) * capacity_];
+                uint64_t *high = &columns_[(j + k + 1) * capacity_];
+                for (size_t i = 0; i < count; i++) {
+                    uint64_t partial = (uint64_t)a[i] * b[i];
+                    low[i] += (uint32_t)partial;
+                    high[i] += partial >> 32;
+                }
+            }
+        }
+
+        for (size_t column = 0; column < product_words; column++) {
+            uint64_t *sum = &columns_[column * capacity_];
+            uint32_t *product = &product_[column * capacity_];
+            if (column + 1 < product_words) {
+                uint64_t *next = &columns_[(column + 1) * capacity_];
+                for (size_t i = 0; i < count; i++) {
+                    next[i] += sum[i] >> 32;
+                }
+            }
+            for (size_t i = 0; i < count; i++) {
+                product[i] = (uint32_t)sum[i];
+            }
+        }
+    }
+
+    WideUint<2 * Words> product(size_t i) const {
+        WideUint<2 * Words> value;
+        for (size_t word = 0; word < product_words; word++) {
+            value.words[word] = product_[word * capacity_ + i];
+        }
+        return value;
+    }
+
+  private:
+    size_t capacity_;
+    std::vector<uint32_t> a_;
+    std::vector<uint32_t> b_;
+    std::vector<uint64_t> columns_;
+    std::vector<uint32_t> product_;
+};
+
+// One product, for checks that only need a few
+template <size_t Words>
+WideUint<2 * Words> wide_mul(const WideUint<Words> &a, const WideUint<Words> &b) {
+    WideUint<2 * Words> product;
+    for (size_t j = 0; j < Words; j++) {
+        uint64_t carry = 0;
+        for (size_t k = 0; k < Words; k++) {
+            uint64_t sum = (uint64_t)a.words[j] * b.words[k]
+                         + product.words[j + k] + carry;
+            product.words[j + k] = (uint32_t)sum;
+            carry = sum >> 32;
+        }
+        product.words[j + Words] = (uint32_t)carry;
+    }
+    return product;
+}
+
+#endif
@@ -0,0 +1,86 @@
+// For std::unique_ptr
+#include <memory>
+#include <cstdint>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmux_sim_top.h"
+
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Benchmark timing and JSON output
+#include "sim_bench.h"
+
+// The DATA_W parameter of mux_sim_top, the Makefile passes both
+#ifndef MUX_DATA_W
+#define MUX_DATA_W 8
+#endif
+#define MUX_DATA_MASK ((1ULL << MUX_DATA_W) - 1)
+
+// Number of input vectors per run, change with +bench_size
+#define BENCH_DEFAULT_SIZE 1000000
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    contextp->debug(0);
+
+    // Randomization reset policy
+    contextp->randReset(2);
+}
+
+// Applies random input vectors, one per timestep, and checks each output
+static void run_workload(uint64_t size, BenchRun &run) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    init_context(contextp);
+    const std::unique_ptr<Vmux_sim_top> top{new Vmux_sim_top{contextp.get(), "TOP"}};
+
+    SimRand rand{0};
+    run.start();
+    for (uint64_t i = 0; i < size; i++) {
+        uint64_t bits = rand.next();
+        // At most 8 bits of each input, so they fit a byte at any width
+        uint8_t data[4] = {
+            (uint8_t)(bits & MUX_DATA_MASK),
+            (uint8_t)((bits >> 8) & MUX_DATA_MASK),
+            (uint8_t)((bits >> 16) & MUX_DATA_MASK),
+            (uint8_t)((bits >> 24) & MUX_DATA_MASK)
+        };
+        uint8_t data_sel = (bits >> 32) & 0x3;
+
+        top->data_0 = data[0];
+        top->data_1 = data[1];
+        top->data_2 = data[2];
+        top->data_3 = data[3];
+        top->data_sel = data_sel;
+
+        contextp->timeInc(1);
+        top->eval();
+
+        if (top->data_out != data[data_sel]) {
+            run.errors++;
+        }
+    }
+    run.stop();
+
+    run.cycles = size;
+    run.evals = size;
+    run.transactions = size;
+    top->final();
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    const SimArgs args{argc, argv};
+    SimBench bench{"mux_sim_top", args, BENCH_DEFAULT_SIZE};
+    bench.add_build_info();
+
+    bench.run(run_workload);
+
+    return bench.report() ? 0 : 1;
+}
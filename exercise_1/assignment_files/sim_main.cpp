@@ -8,10 +8,48 @@
 // Include model header, generated from Verilating "top.v"
 #include "Vmux_sim_top.h"
 
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Waveform tracing
+#include "sim_trace.h"
+// Multithreaded sweeps
+#include "sim_shard.h"
+// Lockstep checking of combinational logic
+#include "sim_comb.h"
+
+// The DATA_W parameter of mux_sim_top, the Makefile passes both
+#ifndef MUX_DATA_W
+#define MUX_DATA_W 8
+#endif
+// The directed tests drive values up to 8, and the lockstep check takes the
+// other three inputs' backgrounds out of one 64 bit word
+static_assert((MUX_DATA_W >= 4) && (MUX_DATA_W <= 16), "MUX_DATA_W has to be from 4 to 16");
+#define MUX_DATA_MASK ((1ULL << MUX_DATA_W) - 1)
+#define MUX_SEL_W 2
+
+// Background patterns for the lockstep check, change with +comb_passes
+#define COMB_DEFAULT_PASSES 4096
+#define COMB_LANES 16
+#define COMB_CHUNK 4096
+#define COMB_MAX_REPORTED 16
+
+// Set in main(), every evaluation is dumped to it
+static SimTrace<Vmux_sim_top> *trace = nullptr;
+
+// The mux has no clock, so each timestep counts as a cycle for +trace_start
+// and +trace_stop
+static void eval(const std::unique_ptr<VerilatedContext> &contextp,
+                 const std::unique_ptr<Vmux_sim_top> &top) {
+    top->eval();
+    trace->dump(contextp->time());
+}
+
 static void time_step(const std::unique_ptr<VerilatedContext> &contextp,
                     const std::unique_ptr<Vmux_sim_top> &top) {
     contextp->timeInc(1);  // 1 timeprecision period passes...
-    top->eval();
+    eval(contextp, top);
 }
 
 static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
@@ -25,6 +63,14 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
     // May be overridden by commandArgs argument parsing
     contextp->randReset(2);
 
+    // Random initial values depend on +seed=N, so each seed of a regression
+    // starts from a different power-on state
+    // May be overridden by commandArgs argument parsing, with +verilator+seed+N
+    const SimArgs args{argc, argv};
+    if (args.flag("seed")) {
+        contextp->randSeed(sim_verilator_seed(args.u64("seed", 0)));
+    }
+
     // Verilator must compute traced signals
     contextp->traceEverOn(true);
 
@@ -33,10 +79,14 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
     contextp->commandArgs(argc, argv);
 }
 
+// Failed checks, for the exit code
+static uint64_t check_errors = 0;
+
 // Modify as needed for debugging
 static void check_output(const std::unique_ptr<Vmux_sim_top> &top,
                         uint8_t expected_value ) {
     if (top->data_out != expected_value) {
+        check_errors++;
         printf("==ERROR==\n");
         printf("Wrong value when data_sel = %d\n", top->data_sel);
         printf("Expected: %hhu, Got: %hhu\n", expected_value, top->data_out);
@@ -54,6 +104,68 @@ static void print_status(const std::unique_ptr<VerilatedContext> &contextp,
 }
 
 
+/*******************************************************************************
+ * Lockstep check, see sim_comb.h
+ *
+ * Vector i drives every select value with every value on the selected input:
+ * the select is the low MUX_SEL_W bits of i and the selected input the next
+ * MUX_DATA_W bits. The other inputs hold a background pattern, which changes
+ * once all of those have been through. The first backgrounds are all zeroes
+ * and all ones, so a wrong input or a stuck bit shows up straight away, and
+ * the rest are scrambled from the pass number.
+ ******************************************************************************/
+static uint64_t comb_background(uint64_t pass) {
+    if (pass < 2) {
+        return (pass == 0) ? 0 : ~0ULL;
+    }
+    uint64_t z = pass * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void comb_inputs(uint64_t i, uint64_t *data, uint64_t &data_sel) {
+    data_sel = i & ((1 << MUX_SEL_W) - 1);
+    uint64_t background = comb_background(i >> (MUX_SEL_W + MUX_DATA_W));
+    for (unsigned input = 0; input < 4; input++) {
+        data[input] = (background >> (MUX_DATA_W * input)) & MUX_DATA_MASK;
+    }
+    data[data_sel] = (i >> MUX_SEL_W) & MUX_DATA_MASK;
+}
+
+static void comb_apply(Vmux_sim_top *top, uint64_t i) {
+    uint64_t data[4];
+    uint64_t data_sel;
+    comb_inputs(i, data, data_sel);
+    top->data_0 = data[0];
+    top->data_1 = data[1];
+    top->data_2 = data[2];
+    top->data_3 = data[3];
+    top->data_sel = data_sel;
+}
+
+static uint64_t comb_sample(const Vmux_sim_top *top) {
+    return top->data_out;
+}
+
+static void comb_reference(uint64_t first, uint64_t count, uint64_t *expected) {
+    for (uint64_t i = 0; i < count; i++) {
+        expected[i] = ((first + i) >> MUX_SEL_W) & MUX_DATA_MASK;
+    }
+}
+
+static void comb_describe(uint64_t i) {
+    uint64_t data[4];
+    uint64_t data_sel;
+    comb_inputs(i, data, data_sel);
+    VL_PRINTF("    data_sel=%" VL_PRI64 "u data_0=%" VL_PRI64 "x data_1=%" VL_PRI64 "x \
+data_2=%" VL_PRI64 "x data_3=%" VL_PRI64 "x\n", data_sel, data[0], data[1], data[2], data[3]);
+}
+
+static const CombBlock<Vmux_sim_top> mux_block = {
+    comb_apply, comb_sample, comb_reference, comb_describe
+};
+
 int main(int argc, char** argv, char** env) {
     // Prevent unused variable warnings
     if (false && argc && argv && env) {}
@@ -72,6 +184,11 @@ int main(int argc, char** argv, char** env) {
     // "TOP" will be the hierarchical name of the module.
     const std::unique_ptr<Vmux_sim_top> top{new Vmux_sim_top{contextp.get(), "TOP"}};
 
+    // Waveforms with +trace, see sim_trace.h for the options
+    const SimArgs args{argc, argv};
+    SimTrace<Vmux_sim_top> model_trace{contextp.get(), top.get(), args};
+    trace = &model_trace;
+
     // Set some initial data values
     top->data_0 = 1;
     top->data_1 = 2;
@@ -91,7 +208,7 @@ int main(int argc, char** argv, char** env) {
 
     contextp->timeInc(1);   // Advance time
     top->data_sel = 1;      // Modify the input signals
-    top->eval();            // Update the signals
+    eval(contextp, top);    // Update the signals
     print_status(contextp, top);
 
     // Check the output (in the same timestep)
@@ -99,7 +216,7 @@ int main(int argc, char** argv, char** env) {
     
     contextp->timeInc(1);  // Advance time
     top->data_sel = 2;     // Modify the input signals
-    top->eval();           // Update the signals
+    eval(contextp, top);   // Update the signals
     print_status(contextp, top);
 
     // Check the output (in the same timestep)
@@ -107,7 +224,7 @@ int main(int argc, char** argv, char** env) {
     
     contextp->timeInc(1);   // Advance time
     top->data_sel = 3;      // Modify the input signals
-    top->eval();            // Update the signals
+    eval(contextp, top);    // Update the signals
     print_status(contextp, top);
 
     // Check the output (in the same timestep)
@@ -120,7 +237,7 @@ int main(int argc, char** argv, char** env) {
      **************************************************************************/
     contextp->timeInc(1);  // Advance time
     top->data_3 = 8;       // Modify the input signals
-    top->eval();           // Update the signals
+    eval(contextp, top);   // Update the signals
 
     check_output(top, 8);
     print_status(contextp, top);
@@ -128,11 +245,33 @@ int main(int argc, char** argv, char** env) {
      ***************************ADD MORE TESTS HERE****************************
      **************************************************************************/
 
+    /**************************************************************************
+     * Check every select value against every data value on lots of copies of
+     * the model at once. +comb=N runs on N threads, +comb or +comb=0 on all
+     * of the cores
+     **************************************************************************/
+    uint64_t comb_failed = 0;
+    if (args.flag("comb")) {
+        unsigned num_workers = (unsigned)args.u64("comb", 0);
+        if (num_workers == 0) {
+            num_workers = default_shard_count();
+        }
+        uint64_t passes = args.u64("comb_passes", COMB_DEFAULT_PASSES);
+        uint64_t num_vectors = passes << (MUX_SEL_W + MUX_DATA_W);
+        printf("Run lockstep exhaustive testing\n");
+        comb_failed = run_comb(mux_block, num_vectors, num_workers,
+                 (unsigned)args.u64("comb_lanes", COMB_LANES), COMB_CHUNK,
+                 COMB_MAX_REPORTED).failed;
+    }
+
     time_step(contextp, top);
     time_step(contextp, top);
 
     // Final model cleanup
     top->final();
+
+    // Flush the rest of the trace
+    model_trace.close();
     
-    return 0;
+    return ((check_errors == 0) && (comb_failed == 0)) ? 0 : 1;
 }
@@ -12,8 +12,9 @@ module lot_counter_top (
     ,output logic   [COUNTER_W-1:0] count
 );
 
-    logic   [COUNTER_W-1:0] curr_counter;
-    state_e                 curr_state;
+    // Readable from the harness, which skips cycles where they don't change
+    logic   [COUNTER_W-1:0] curr_counter    /*verilator public_flat_rd*/;
+    state_e                 curr_state      /*verilator public_flat_rd*/;
 
     logic   [COUNTER_W-1:0] counter_next;
     state_e                 state_next;
@@ -32,11 +33,9 @@ module lot_counter_top (
     // TODO: instantiate the state logic module here
     
     initial begin
-       if ($test$plusargs("trace") != 0) begin
-          $display("[%0t] Tracing to logs/vlt_dump.vcd...\n", $time);
-          $dumpfile("logs/vlt_dump.vcd");
-          $dumpvars();
+       // +quiet for harness modes that build a model per run, e.g. +reset_sweep
+       if (!$test$plusargs("quiet")) begin
+           $display("[%0t] Model running...\n", $time);
        end
-       $display("[%0t] Model running...\n", $time);
     end
 endmodule
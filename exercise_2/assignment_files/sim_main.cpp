@@ -1,17 +1,60 @@
 // For std::unique_ptr
 #include <memory>
 #include <cstdint>
+#include <vector>
 
 // Include common routines
 #include <verilated.h>
 
 // Include model header, generated from Verilating "top.v"
 #include "Vlot_counter_top.h"
+// For the state registers, which lot_counter_top marks public
+#include "Vlot_counter_top___024root.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Waveform tracing
+#include "sim_trace.h"
+// Flight recorder for failures
+#include "sim_flight.h"
+// Binary event log
+#include "sim_log.h"
+// Scenarios run from snapshots
+#include "sim_scenario.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Recorded stimulus and expected outputs
+#include "sim_vectors.h"
+// Functional coverage
+#include "sim_cover.h"
+// Randomized reset sweep
+#include "sim_reset.h"
 
 #define CLOCK_HALF_CYCLE_NS 5
 #define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+// Cycles the flight recorder keeps before and after a failure by default
+#define FLIGHT_DEFAULT_CYCLES 64
+#define FLIGHT_DEFAULT_POST 16
 #define MAX_CAPACITY 16
 
+// Cars in the random traffic scenario, change with +traffic_cars
+#define TRAFFIC_DEFAULT_CARS 1000
+// Most cycles between cars, +traffic_idle=N
+#define TRAFFIC_DEFAULT_IDLE 64
+// Most cycles each sensor change is held for
+#define TRAFFIC_MAX_HOLD 4
+#define REPLAY_MAX_REPORTED 16
+// Cars the traffic scenario goes on for without covering anything new before
+// it stops, with +cover. Change with +cover_plateau
+#define TRAFFIC_COVER_PLATEAU 1000
+// state_e is 3 bits
+#define LOT_NUM_STATES 8
+// Seeds and cycles after reset for +reset_sweep with no count
+#define RESET_SWEEP_SEEDS 4096
+#define RESET_SWEEP_CYCLES 16
+
 static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
                          int argc,
                          char ** argv) {
@@ -23,6 +66,14 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
     // May be overridden by commandArgs argument parsing
     contextp->randReset(2);
 
+    // Random initial values depend on +seed=N, so each seed of a regression
+    // starts from a different power-on state
+    // May be overridden by commandArgs argument parsing, with +verilator+seed+N
+    const SimArgs args{argc, argv};
+    if (args.flag("seed")) {
+        contextp->randSeed(sim_verilator_seed(args.u64("seed", 0)));
+    }
+
     // Verilator must compute traced signals
     contextp->traceEverOn(true);
 
@@ -32,21 +83,159 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
 
 }
 
-static void time_step(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vlot_counter_top> &top) {
-    contextp->timeInc(1);  // 1 timeprecision period passes...
-    top->eval();
+/*******************************************************************************
+ * Flight recorder, see sim_flight.h. +flight=N keeps the last N cycles of the
+ * ports and dumps them to logs/flight_*.vcd along with +flight_post=M cycles
+ * after each failure
+ ******************************************************************************/
+static const std::vector<FlightSignal> flight_signals = {
+    {"clk", 1},
+    {"rst", 1},
+    {"outer_sensor", 1},
+    {"inner_sensor", 1},
+    {"full", 1},
+    {"empty", 1},
+    {"count", 5}
+};
+
+static void flight_sample(const Vlot_counter_top *top, uint64_t *values) {
+    values[0] = top->clk;
+    values[1] = top->rst;
+    values[2] = top->outer_sensor;
+    values[3] = top->inner_sensor;
+    values[4] = top->full;
+    values[5] = top->empty;
+    values[6] = top->count;
+}
+
+// Set by run_scenario() when the flight recorder is on. Scenarios run on
+// their own threads, so each thread has its own
+static thread_local FlightRecorder<Vlot_counter_top> *flight = nullptr;
+// Failed checks in the scenario running on this thread
+static thread_local uint64_t check_errors = 0;
+
+static void flight_trigger(const char *reason) {
+    if (flight != nullptr) {
+        flight->trigger(reason);
+    }
+}
+
+/*******************************************************************************
+ * Event log, see sim_log.h. The status lines are printed as they happen, or
+ * with +log go to logs/events.bin for sim_log_decode to print afterwards
+ ******************************************************************************/
+enum LogEvent {
+    LOG_STATUS
+};
+
+static const std::vector<SimLogEvent> log_events = {
+    {SIM_LOG_STATUS, "status", "[%" VL_PRI64 "d] inner_sensor: %d, outer_sensor: %d, count: %d, \
+full: %d, empty: %d\n"}
+};
+
+// Set in run_scenario()
+static thread_local SimLog *event_log = nullptr;
+
+/*******************************************************************************
+ * Vector files, see sim_vectors.h. +record writes logs/vectors_<scenario>.vec
+ * for each scenario, +replay=<file> drives one back onto the model
+ ******************************************************************************/
+static void vec_drive(Vlot_counter_top *top, const uint64_t *inputs) {
+    top->rst = inputs[0];
+    top->outer_sensor = inputs[1];
+    top->inner_sensor = inputs[2];
+}
+
+static void vec_read_inputs(const Vlot_counter_top *top, uint64_t *inputs) {
+    inputs[0] = top->rst;
+    inputs[1] = top->outer_sensor;
+    inputs[2] = top->inner_sensor;
+}
+
+static void vec_sample(const Vlot_counter_top *top, uint64_t *outputs) {
+    outputs[0] = top->count;
+    outputs[1] = top->full;
+    outputs[2] = top->empty;
+}
+
+// Both registers of lot_counter_state_regs
+static uint64_t lot_state(const Vlot_counter_top *top) {
+    return ((uint64_t)top->rootp->lot_counter_top__DOT__curr_state << 8)
+         | top->rootp->lot_counter_top__DOT__curr_counter;
 }
 
-static void clock_cycle(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vlot_counter_top> &top) {
-    top->clk = !top->clk;
-    for (int i = 0; i < CLOCK_HALF_CYCLE_NS; i++) {
-        time_step(contextp, top);
+static const VecBinding<Vlot_counter_top> vec_binding = {
+    {{"rst", 1}, {"outer_sensor", 1}, {"inner_sensor", 1}},
+    {{"count", 5}, {"full", 1}, {"empty", 1}},
+    vec_drive, vec_read_inputs, vec_sample, lot_state
+};
+
+// Set in main() with +replay
+static const VecFile *replay_file = nullptr;
+
+/*******************************************************************************
+ * Fast-forward. The lot counter's next state only depends on its state and the
+ * sensors, so once a cycle goes by with the sensors held and the state
+ * registers unchanged, nothing changes until the sensors do. With
+ * +fast_forward, those cycles are skipped over instead of evaluated
+ ******************************************************************************/
+// Set in main()
+static bool fast_forward = false;
+
+/*******************************************************************************
+ * Coverage, see sim_cover.h. With +cover, the traffic scenario counts what it
+ * has done, and which states and transitions of the state register it has
+ * seen, and stops once it has done everything or stops finding anything new
+ ******************************************************************************/
+struct LotCoverage {
+    SimCoverage cover;
+    unsigned entered;
+    unsigned left;
+    unsigned filled;
+    unsigned emptied;
+    unsigned held;
+    unsigned states;
+    unsigned transitions;
+    uint64_t state;
+
+    LotCoverage(uint64_t plateau, const Vlot_counter_top *top)
+        : cover{plateau}
+        , state{top->rootp->lot_counter_top__DOT__curr_state} {
+        entered = cover.add_goal("car entered");
+        left = cover.add_goal("car left");
+        filled = cover.add_goal("lot filled up");
+        emptied = cover.add_goal("lot emptied after filling up");
+        held = cover.add_goal("sensor held for 4 cycles");
+        states = cover.add_values("curr_state", LOT_NUM_STATES);
+        transitions = cover.add_values("curr_state from * 8 + to",
+                                       LOT_NUM_STATES * LOT_NUM_STATES);
+    }
+
+    // Call after every evaluated cycle
+    void sample(const Vlot_counter_top *top) {
+        uint64_t next = top->rootp->lot_counter_top__DOT__curr_state;
+        cover.hit_value(states, next);
+        cover.hit_value(transitions, state * LOT_NUM_STATES + next);
+        state = next;
     }
-    top->clk = !top->clk;
-    for (int i = 0; i < CLOCK_HALF_CYCLE_NS; i++) {
-        time_step(contextp, top);
+};
+
+// Set by random_traffic() with +cover
+static thread_local LotCoverage *lot_cover = nullptr;
+
+// Holds the inputs as they are for n cycles
+static void hold_cycles(SimClock<Vlot_counter_top> &sim, uint64_t n) {
+    Vlot_counter_top *top = sim.top();
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t state = lot_state(top);
+        sim.cycle();
+        if (lot_cover != nullptr) {
+            lot_cover->sample(top);
+        }
+        if (fast_forward && (lot_state(top) == state)) {
+            sim.skip_cycles(n - i - 1);
+            return;
+        }
     }
 }
 
@@ -61,6 +250,8 @@ static void check_output(const std::unique_ptr<VerilatedContext> &contextp,
                     || ((top->count != 0) && (top->empty));
     if (count_wrong | full_wrong | empty_wrong) {
         printf("==ERROR==\n");
+        check_errors++;
+        flight_trigger("check_output failed");
         if (count_wrong) {
             printf("Wrong count\n");
             printf("Expected: %u, Got: %u\n", expected_count, top->count);
@@ -79,32 +270,25 @@ static void check_output(const std::unique_ptr<VerilatedContext> &contextp,
 }
 
 // Modify as needed for debugging
+static void print_status(const VerilatedContext *contextp,
+                        const Vlot_counter_top *top) {
+    // Read outputs
+    event_log->log(LOG_STATUS, contextp->time(), {top->inner_sensor, top->outer_sensor,
+            top->count, top->full, top->empty});
+}
+
 static void print_status(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vlot_counter_top> &top) {
-    // Read outputs
-    VL_PRINTF("[%" VL_PRI64 "d] inner_sensor: %d, outer_sensor: %d, count: %d, \
-full: %d, empty: %d\n",
-            contextp->time(), top->inner_sensor, top->outer_sensor, top->count,
-            top->full, top->empty);
+    print_status(contextp.get(), top.get());
 }
 
-int main(int argc, char** argv, char** env) {
-    // Prevent unused variable warnings
-    if (false && argc && argv && env) {}
-    
-    // Create logs/ directory in case we have traces to put under it
-    Verilated::mkdir("logs");
-    
-    // Using unique_ptr is similar to
-    // "VerilatedContext* contextp = new VerilatedContext" then deleting at end.
-    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
-    
-    init_context(contextp, argc, argv);
-    
-    // Construct the Verilated model, from Vmux_sim_top.h generated from
-    // Verilating "log_counter_top".  
-    // "TOP" will be the hierarchical name of the module.
-    const std::unique_ptr<Vlot_counter_top> top{new Vlot_counter_top{contextp.get(), "TOP"}};
+/*******************************************************************************
+ * Reset
+ ******************************************************************************/
+// Leaves rst just released, where the reset sweep starts sampling. log adds
+// the status in reset to the event log, the reset sweep has none
+static void reset_lot(SimClock<Vlot_counter_top> &sim, bool log) {
+    Vlot_counter_top *top = sim.top();
 
     // Set some initial data values
     top->inner_sensor = 0;
@@ -112,183 +296,489 @@ int main(int argc, char** argv, char** env) {
     top->clk = 0;
     top->rst = 1;
 
-    clock_cycle(contextp, top); // Kick the simulation
-    clock_cycle(contextp, top);
+    sim.cycle(); // Kick the simulation
+    sim.cycle();
     
-    print_status(contextp, top);
+    if (log) {
+        print_status(sim.contextp(), top);
+    }
     top->rst = 0;
-    clock_cycle(contextp, top);
+}
+
+static void reset_lot(const std::unique_ptr<VerilatedContext> &contextp,
+                      const std::unique_ptr<Vlot_counter_top> &top,
+                      SimClock<Vlot_counter_top> &sim) {
+    reset_lot(sim, true);
+    sim.cycle();
+}
 
-    /***************************************************************************
-     * One car enters
-     **************************************************************************/
+/*******************************************************************************
+ * One car enters
+ ******************************************************************************/
+static void one_car_enters(const std::unique_ptr<VerilatedContext> &contextp,
+                           const std::unique_ptr<Vlot_counter_top> &top,
+                           SimClock<Vlot_counter_top> &sim) {
     top->outer_sensor = 1;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->inner_sensor = 1;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->outer_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->inner_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
 
     // Okay, great, check the current count value
     print_status(contextp, top);
     check_output(contextp, top, 1);
-    
-    /***************************************************************************
-     * Fill up the lot
-     **************************************************************************/
+}
+
+/*******************************************************************************
+ * Fill up the lot
+ ******************************************************************************/
+static void fill_lot(const std::unique_ptr<VerilatedContext> &contextp,
+                     const std::unique_ptr<Vlot_counter_top> &top,
+                     SimClock<Vlot_counter_top> &sim) {
     for (int i = 0; i < MAX_CAPACITY-1; i++) {
         top->outer_sensor = 1;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, i + 1);
 
         top->inner_sensor = 1;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, i + 1);
 
         top->outer_sensor = 0;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, i + 1);
 
         top->inner_sensor = 0;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
 
         // Okay, great, check the current count value
         print_status(contextp, top);
         check_output(contextp, top, i + 2);
     }
-    
-    /***************************************************************************
-     * One car leaves
-     **************************************************************************/
+}
+
+/*******************************************************************************
+ * One car leaves
+ ******************************************************************************/
+static void one_car_leaves(const std::unique_ptr<VerilatedContext> &contextp,
+                           const std::unique_ptr<Vlot_counter_top> &top,
+                           SimClock<Vlot_counter_top> &sim) {
     top->inner_sensor = 1;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, MAX_CAPACITY);
 
     top->outer_sensor = 1;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, MAX_CAPACITY);
 
     top->inner_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     check_output(contextp, top, MAX_CAPACITY);
 
     top->outer_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
 
     print_status(contextp, top);
     check_output(contextp, top, MAX_CAPACITY - 1);
-    
-    /***************************************************************************
-     * Empty the lot
-     **************************************************************************/
+}
 
+/*******************************************************************************
+ * Empty the lot
+ ******************************************************************************/
+static void empty_lot(const std::unique_ptr<VerilatedContext> &contextp,
+                      const std::unique_ptr<Vlot_counter_top> &top,
+                      SimClock<Vlot_counter_top> &sim) {
     for (int i = 0; i < MAX_CAPACITY-1; i++) {
         top->inner_sensor = 1;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, MAX_CAPACITY - 1 - i);
 
         top->outer_sensor = 1;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, MAX_CAPACITY - 1 - i);
 
         top->inner_sensor = 0;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
         check_output(contextp, top, MAX_CAPACITY - 1 - i);
 
         top->outer_sensor = 0;
 
-        clock_cycle(contextp, top);
+        sim.cycle();
 
         print_status(contextp, top);
         check_output(contextp, top, MAX_CAPACITY - 2 - i);
     }
-    
-    /***************************************************************************
-     * Check that we can hold sensors high for more than one cycle on enter
-     **************************************************************************/
+}
+
+/*******************************************************************************
+ * Check that we can hold sensors high for more than one cycle on enter
+ ******************************************************************************/
+static void hold_on_enter(const std::unique_ptr<VerilatedContext> &contextp,
+                          const std::unique_ptr<Vlot_counter_top> &top,
+                          SimClock<Vlot_counter_top> &sim) {
     top->outer_sensor = 1;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->inner_sensor = 1;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->outer_sensor = 0;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 0);
 
     top->inner_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
     // Okay, great, check the current count value
     print_status(contextp, top);
     check_output(contextp, top, 1);
-    
-    /***************************************************************************
-     * Check that we can hold sensors high for more than one cycle on exit
-     **************************************************************************/
+}
+
+/*******************************************************************************
+ * Check that we can hold sensors high for more than one cycle on exit
+ ******************************************************************************/
+static void hold_on_exit(const std::unique_ptr<VerilatedContext> &contextp,
+                         const std::unique_ptr<Vlot_counter_top> &top,
+                         SimClock<Vlot_counter_top> &sim) {
     top->inner_sensor = 1;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 1);
 
     top->outer_sensor = 1;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 1);
 
     top->inner_sensor = 0;
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
     check_output(contextp, top, 1);
 
     top->outer_sensor = 0;
 
-    clock_cycle(contextp, top);
+    sim.cycle();
 
     print_status(contextp, top);
     check_output(contextp, top, 0);
+}
+
+/*******************************************************************************
+ * Random traffic: cars come and go at random, with quiet stretches in between
+ * and the sensors held for a random number of cycles
+ ******************************************************************************/
+// Set from the plusargs in main()
+struct TrafficConfig {
+    uint64_t seed;
+    uint64_t cars;
+    uint64_t max_idle;
+    bool cover;
+    uint64_t cover_plateau;
+};
+
+static TrafficConfig traffic;
+
+static void random_traffic(const std::unique_ptr<VerilatedContext> &contextp,
+                           const std::unique_ptr<Vlot_counter_top> &top,
+                           SimClock<Vlot_counter_top> &sim) {
+    SimRand rand{traffic.seed};
+    uint32_t count = 0;
+    bool been_full = false;
+
+    std::unique_ptr<LotCoverage> coverage;
+    if (traffic.cover) {
+        coverage.reset(new LotCoverage{traffic.cover_plateau, top.get()});
+    }
+    lot_cover = coverage.get();
+
+    for (uint64_t car = 0; car < traffic.cars; car++) {
+        hold_cycles(sim, rand.below(traffic.max_idle + 1));
+
+        // A car going in trips the outer sensor first, one coming out the
+        // inner one
+        bool enter = (count == 0) || ((count < MAX_CAPACITY) && rand.chance(1, 2));
+        CData &first = enter ? top->outer_sensor : top->inner_sensor;
+        CData &second = enter ? top->inner_sensor : top->outer_sensor;
+        CData *steps[3] = {&first, &second, &first};
+        CData levels[3] = {1, 1, 0};
+        for (int step = 0; step < 3; step++) {
+            *steps[step] = levels[step];
+            uint64_t hold = 1 + rand.below(TRAFFIC_MAX_HOLD);
+            hold_cycles(sim, hold);
+            check_output(contextp, top, count);
+            if ((lot_cover != nullptr) && (hold == TRAFFIC_MAX_HOLD)) {
+                lot_cover->cover.hit(lot_cover->held);
+            }
+        }
+
+        second = 0;
+        hold_cycles(sim, 1);
+        count = enter ? count + 1 : count - 1;
+        check_output(contextp, top, count);
+
+        if (lot_cover != nullptr) {
+            LotCoverage &c = *lot_cover;
+            c.cover.hit(enter ? c.entered : c.left);
+            if (count == MAX_CAPACITY) {
+                c.cover.hit(c.filled);
+                been_full = true;
+            }
+            if ((count == 0) && been_full) {
+                c.cover.hit(c.emptied);
+            }
+            if (c.cover.done(car + 1)) {
+                break;
+            }
+        }
+    }
+    print_status(contextp, top);
+
+    if (lot_cover != nullptr) {
+        lot_cover->cover.report("Traffic");
+        lot_cover = nullptr;
+    }
+}
+
+/*******************************************************************************
+ * Replay of a vector file, with +replay=<file>
+ ******************************************************************************/
+static void replay_lot(const std::unique_ptr<VerilatedContext> &contextp,
+                       const std::unique_ptr<Vlot_counter_top> &top,
+                       SimClock<Vlot_counter_top> &sim) {
+    VecReplay replay = replay_vectors(sim, vec_binding, *replay_file, REPLAY_MAX_REPORTED,
+                                      flight_trigger, fast_forward);
+    check_errors += replay.errors;
+    print_status(contextp, top);
+    VL_PRINTF("Replayed %" VL_PRI64 "u vectors, %" VL_PRI64 "u cycles, from %s with \
+%" VL_PRI64 "u mismatches\n", replay.records, replay.cycles, replay_file->path().c_str(),
+            replay.errors);
+}
+
+typedef void (*LotScenarioFn)(const std::unique_ptr<VerilatedContext> &contextp,
+                              const std::unique_ptr<Vlot_counter_top> &top,
+                              SimClock<Vlot_counter_top> &sim);
+typedef SimScenario<LotScenarioFn> LotScenario;
+
+// Every scenario starts from the snapshot another one saved. The hold tests
+// only need an empty lot and a lot with one car, so they start from reset and
+// one_car instead of waiting for the lot to fill up and empty out again.
+// Rerun one of them with +scenario=<name>
+static const std::vector<LotScenario> lot_scenarios = {
+    // name              from        saves
+    {"reset",            nullptr,    "reset",    reset_lot},
+    {"one_car_enters",   "reset",    "one_car",  one_car_enters},
+    {"fill_lot",         "one_car",  "full",     fill_lot},
+    {"one_car_leaves",   "full",     "one_left", one_car_leaves},
+    {"empty_lot",        "one_left", nullptr,    empty_lot},
+    {"hold_on_enter",    "reset",    nullptr,    hold_on_enter},
+    {"hold_on_exit",     "one_car",  nullptr,    hold_on_exit},
+    {"traffic",          "reset",    nullptr,    random_traffic}
+};
+
+// Runs one scenario on a model of its own, returns true if it passed
+static bool run_scenario(int argc, char **argv, const SimArgs &args,
+                         const LotScenario &scenario) {
+    // Using unique_ptr is similar to
+    // "VerilatedContext* contextp = new VerilatedContext" then deleting at end.
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    
+    init_context(contextp, argc, argv);
+
+    // Construct the Verilated model, from Vmux_sim_top.h generated from
+    // Verilating "log_counter_top".  
+    // "TOP" will be the hierarchical name of the module.
+    const std::unique_ptr<Vlot_counter_top> top{new Vlot_counter_top{contextp.get(), "TOP"}};
+
+    // Only evaluates the model on clock edges
+    SimClock<Vlot_counter_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    // Waveforms with +trace, see sim_trace.h for the options. Each scenario
+    // gets its own file
+    SimTrace<Vlot_counter_top> trace{contextp.get(), top.get(), args, scenario.name};
+    trace.attach(sim);
+
+    // Keeps the last few cycles of the ports to dump around a failure
+    std::unique_ptr<FlightRecorder<Vlot_counter_top>> flight_recorder;
+    if (args.flag("flight")) {
+        flight_recorder.reset(new FlightRecorder<Vlot_counter_top>{sim, flight_signals,
+                flight_sample, args.u64("flight", FLIGHT_DEFAULT_CYCLES),
+                args.u64("flight_post", FLIGHT_DEFAULT_POST),
+                std::string{"logs/flight_"} + scenario.name});
+    }
+    flight = flight_recorder.get();
+    check_errors = 0;
+
+    // print_status() output, each scenario gets its own file with +log
+    SimLog scenario_log{args, log_events, scenario.name};
+    event_log = &scenario_log;
+
+    if (scenario.from != nullptr) {
+        restore_snapshot(scenario.from, contextp.get(), top.get());
+    }
+
+    // Everything the scenario drives and what came out, to replay later
+    std::unique_ptr<VecRecorder<Vlot_counter_top>> recorder;
+    if (args.flag("record")) {
+        recorder.reset(new VecRecorder<Vlot_counter_top>{sim, vec_binding,
+                std::string{"logs/vectors_"} + scenario.name + ".vec", scenario.from});
+    }
+    VL_PRINTF("[%" VL_PRI64 "d] Scenario %s\n", contextp->time(), scenario.name);
+
+    scenario.run(contextp, top, sim);
+
+    if (scenario.saves != nullptr) {
+        save_snapshot(scenario.saves, contextp.get(), top.get());
+    }
+
+    VL_PRINTF("Scenario %s simulated %" VL_PRI64 "u cycles with %" VL_PRI64 "u evals, \
+%" VL_PRI64 "u cycles skipped\n", scenario.name, sim.cycles(), sim.evals(),
+            sim.skipped_cycles());
+
+    if (flight != nullptr) {
+        flight->finish();
+        flight = nullptr;
+    }
+    if (recorder) {
+        recorder->close();
+    }
+    scenario_log.close();
+    event_log = nullptr;
+
+    // Final model cleanup
+    top->final();
+
+    // Flush the rest of the trace
+    trace.close();
+
+    return check_errors == 0;
+}
+
+/*******************************************************************************
+ * Reset sweep, see sim_reset.h. +reset_sweep=N resets N models with different
+ * random initial values, from +seed=S on, and reports the outputs that don't
+ * come out of reset the same way every time
+ ******************************************************************************/
+static const std::vector<ResetSignal> reset_signals = {
+    {"full",  -1},
+    {"empty", -1},
+    {"count", -1}
+};
+
+static void reset_sample(const Vlot_counter_top *top, uint64_t *values) {
+    values[0] = top->full;
+    values[1] = top->empty;
+    values[2] = top->count;
+}
+
+static int run_reset_sweep(const SimArgs &args, unsigned num_workers) {
+    const ResetBench<Vlot_counter_top> bench = {
+        [](SimClock<Vlot_counter_top> &sim) { reset_lot(sim, false); }, reset_sample};
+    ResetSweep sweep{reset_signals, args.u64("reset_cycles", RESET_SWEEP_CYCLES)};
+    size_t diverged = sweep.run(bench, args.u64("seed", 0),
+            args.u64("reset_sweep", RESET_SWEEP_SEEDS), num_workers, CLOCK_HALF_CYCLE_NS);
+    sweep.report("lot_counter_top");
+    return (diverged == 0) ? 0 : 1;
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+    
+    // Create logs/ directory in case we have traces to put under it
+    Verilated::mkdir("logs");
+
+    const SimArgs args{argc, argv};
+
+    // Scenarios that don't depend on each other run on up to +shards=N
+    // threads, all of the cores by default
+    unsigned num_workers = (unsigned)args.u64("shards", 0);
+    if (num_workers == 0) {
+        num_workers = default_shard_count();
+    }
+
+    if (args.flag("reset_sweep")) {
+        return run_reset_sweep(args, num_workers);
+    }
+
+    traffic.seed = args.u64("seed", 0);
+    traffic.cars = args.u64("traffic_cars", TRAFFIC_DEFAULT_CARS);
+    traffic.max_idle = args.u64("traffic_idle", TRAFFIC_DEFAULT_IDLE);
+    traffic.cover = args.flag("cover");
+    traffic.cover_plateau = args.u64("cover_plateau", TRAFFIC_COVER_PLATEAU);
+
+    // The vector recorder has to see every cycle
+    fast_forward = args.flag("fast_forward");
+    if (fast_forward && args.flag("record")) {
+        VL_PRINTF("Not fast-forwarding while recording vectors\n");
+        fast_forward = false;
+    }
+
+    // +replay=<file> runs the file instead of the scenarios, starting from
+    // the snapshot it was recorded from
+    if (args.flag("replay")) {
+        VecFile file{args.str("replay", "logs/vectors_traffic.vec")};
+        if (!file.valid() || !file.matches(vec_binding)) {
+            return 1;
+        }
+        if ((file.start() != nullptr) && !snapshot_exists(file.start())) {
+            VL_PRINTF("%s starts from %s, which isn't there. Run the scenarios first\n",
+                    file.path().c_str(), snapshot_path(file.start()).c_str());
+            return 1;
+        }
+        replay_file = &file;
+        LotScenario replay{"replay", file.start(), nullptr, replay_lot};
+        return run_scenario(argc, argv, args, replay) ? 0 : 1;
+    }
+
+    // Fill in more testing as needed, by adding to lot_scenarios
 
+    bool passed = run_scenarios<LotScenarioFn>(lot_scenarios,
+            args.str("scenario", nullptr), num_workers,
+            [argc, argv, &args](const LotScenario &scenario) {
+                return run_scenario(argc, argv, args, scenario);
+            });
 
-    // Fill in more testing as needed
+    return passed ? 0 : 1;
 }
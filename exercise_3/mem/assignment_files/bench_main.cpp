@@ -0,0 +1,165 @@
+// For std::unique_ptr
+#include <memory>
+#include <cstdint>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmem_wr_bypass_top.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Benchmark timing and JSON output
+#include "sim_bench.h"
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Bindings of the memory's ports to them
+#include "mem_ports.h"
+
+#define CLOCK_HALF_CYCLE_NS 5
+#define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+#define MAX_CAPACITY 8
+#define DATA_W 8
+#define CYCLE_TIMEOUT 64
+
+// Number of reads per run, change with +bench_size. A write goes in alongside
+// about every other read
+#define BENCH_DEFAULT_SIZE 1000000
+
+// Latency, stalls and occupancy of the reads, and the stalls of the writes,
+// over all runs. Only kept with +perf, so the plain benchmark times the same
+// work as before
+static bool perf = false;
+static ValRdyPerf rd_perf;
+static SimHistogram wr_stall;
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    contextp->debug(0);
+
+    // Randomization reset policy
+    contextp->randReset(2);
+}
+
+// Random reads and writes on both ports every cycle
+static void run_workload(uint64_t size, BenchRun &run) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    init_context(contextp);
+    const std::unique_ptr<Vmem_wr_bypass_top> top{
+                                        new Vmem_wr_bypass_top{contextp.get(), "TOP"}};
+    SimClock<Vmem_wr_bypass_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    top->wr_req_val = 0;
+    top->rd_req_val = 0;
+    top->rd_resp_rdy = 1;
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+    sim.cycle();
+    sim.half_cycle();
+
+    MemWrDriver wr_driver{top.get()};
+    MemRdDriver rd_driver{top.get()};
+    MemRdMonitor rd_monitor{contextp.get(), top.get()};
+    SimRand rand{0};
+
+    // Fill the memory first so every read has a known value
+    std::vector<uint64_t> ref_mem(MAX_CAPACITY);
+    for (uint64_t i = 0; i < MAX_CAPACITY; i++) {
+        ref_mem[i] = rand.bits(DATA_W);
+        wr_driver.push({i, ref_mem[i]});
+    }
+    while (!wr_driver.idle()) {
+        wr_driver.drive();
+        sim.half_cycle();
+        wr_driver.sample();
+        sim.half_cycle();
+    }
+
+    uint64_t start_cycles = sim.cycles();
+    uint64_t start_evals = sim.evals();
+    uint64_t reads_queued = 0;
+    uint64_t idle_cycles = 0;
+    if (perf) {
+        rd_perf.attach(rd_driver, rd_monitor);
+        wr_driver.record_stalls(&wr_stall);
+    }
+
+    run.start();
+    while ((reads_queued < size) || !rd_monitor.idle()) {
+        // Keep a little work queued on both ports
+        if ((reads_queued < size) && (rd_driver.pending() < 2)) {
+            rd_driver.push(rand.below(MAX_CAPACITY));
+            reads_queued++;
+        }
+        if (wr_driver.idle() && rand.chance(1, 2)) {
+            wr_driver.push({rand.below(MAX_CAPACITY), rand.bits(DATA_W)});
+        }
+
+        wr_driver.drive();
+        rd_driver.drive();
+        rd_monitor.drive();
+        sim.half_cycle();
+
+        // A write in the same cycle as a read to the same address is
+        // bypassed, so apply the write to the reference first
+        bool progress = false;
+        if (wr_driver.sample()) {
+            ref_mem[wr_driver.last_sent().addr] = wr_driver.last_sent().data;
+            progress = true;
+        }
+        bool read = rd_driver.sample();
+        if (read) {
+            rd_monitor.expect(ref_mem[rd_driver.last_sent()]);
+            progress = true;
+        }
+        bool received = rd_monitor.sample();
+        progress = received || progress;
+        if (perf) {
+            rd_perf.cycle(read, received);
+        }
+        sim.half_cycle();
+
+        idle_cycles = progress ? 0 : idle_cycles + 1;
+        if (idle_cycles == CYCLE_TIMEOUT) {
+            run.errors++;
+            break;
+        }
+    }
+    run.stop();
+
+    run.cycles = sim.cycles() - start_cycles;
+    run.evals = sim.evals() - start_evals;
+    run.transactions = rd_monitor.received() + wr_driver.sent() - MAX_CAPACITY;
+    run.errors += rd_monitor.errors();
+    top->final();
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    const SimArgs args{argc, argv};
+    SimBench bench{"mem_wr_bypass_top", args, BENCH_DEFAULT_SIZE};
+    bench.add_build_info();
+
+    perf = args.flag("perf");
+    bench.run(run_workload);
+
+    if (perf) {
+        bench.add_info("rd_latency", rd_perf.latency.percentiles());
+        bench.add_info("rd_req_stall", rd_perf.req_stall.percentiles());
+        bench.add_info("rd_resp_stall", rd_perf.resp_stall.percentiles());
+        bench.add_info("rd_in_flight", rd_perf.occupancy.percentiles());
+        bench.add_info("wr_req_stall", wr_stall.percentiles());
+    }
+    return bench.report() ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+//
+// mem_1r1w_sync_wr_bypass with a response buffer, so reads keep going one a
+// cycle while rd_resp_rdy drops now and then.
+//
+// The memory's own response is never held: it goes straight out when the
+// buffer is empty and rd_resp_rdy is high, and into the buffer otherwise.
+// rd_req_rdy comes from a flop, high when the buffer has room for every read
+// already sent, so it doesn't depend on rd_resp_rdy in the same cycle. A
+// BUF_DEPTH of 2 keeps up with rd_resp_rdy held high, each entry past that
+// rides out one more cycle of backpressure without dropping rd_req_rdy
+//
+module mem_1r1w_sync_wr_bypass_skid #(
+     parameter DATA_W = -1
+    ,parameter NUM_ELS = -1
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter BUF_DEPTH = 4
+)(
+     input clk
+    ,input rst
+
+    ,input  logic                   wr_req_val
+    ,input  logic   [ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [DATA_W-1:0]    wr_req_data
+    ,output logic                   wr_req_rdy
+
+    ,input  logic                   rd_req_val
+    ,input  logic   [ADDR_W-1:0]    rd_req_addr
+    ,output logic                   rd_req_rdy
+
+    ,output logic                   rd_resp_val
+    ,output logic   [DATA_W-1:0]    rd_resp_data
+    ,input  logic                   rd_resp_rdy
+);
+
+    localparam PTR_W = (BUF_DEPTH > 1) ? $clog2(BUF_DEPTH) : 1;
+    localparam COUNT_W = $clog2(BUF_DEPTH + 1);
+
+    logic                   mem_rd_req_val;
+    logic                   mem_rd_req_rdy;
+    logic                   mem_rd_resp_val;
+    logic   [DATA_W-1:0]    mem_rd_resp_data;
+
+    logic   [DATA_W-1:0]    buf_data [BUF_DEPTH-1:0];
+    logic   [PTR_W-1:0]     buf_head;
+    logic   [PTR_W-1:0]     buf_tail;
+    logic   [COUNT_W-1:0]   buf_count;
+    logic   [COUNT_W-1:0]   buf_count_next;
+    logic                   buf_empty;
+    logic                   buf_push;
+    logic                   buf_pop;
+
+    // Reads the memory has taken and not answered yet
+    logic   [COUNT_W-1:0]   in_flight;
+    logic   [COUNT_W-1:0]   in_flight_next;
+    logic   [COUNT_W:0]     used_next;
+
+    logic                   rd_req_rdy_reg;
+
+    mem_1r1w_sync_wr_bypass #(
+         .DATA_W    (DATA_W )
+        ,.NUM_ELS   (NUM_ELS)
+        ,.ADDR_W    (ADDR_W )
+    ) mem (
+         .clk   (clk    )
+        ,.rst   (rst    )
+
+        ,.wr_req_val    (wr_req_val         )
+        ,.wr_req_addr   (wr_req_addr        )
+        ,.wr_req_data   (wr_req_data        )
+        ,.wr_req_rdy    (wr_req_rdy         )
+
+        ,.rd_req_val    (mem_rd_req_val     )
+        ,.rd_req_addr   (rd_req_addr        )
+        ,.rd_req_rdy    (mem_rd_req_rdy     )
+
+        ,.rd_resp_val   (mem_rd_resp_val    )
+        ,.rd_resp_data  (mem_rd_resp_data   )
+        ,.rd_resp_rdy   (1'b1               )
+    );
+
+    assign rd_req_rdy = rd_req_rdy_reg;
+    assign mem_rd_req_val = rd_req_val && rd_req_rdy_reg;
+
+    assign buf_empty = buf_count == '0;
+    assign buf_push = mem_rd_resp_val && !(buf_empty && rd_resp_rdy);
+    assign buf_pop = !buf_empty && rd_resp_rdy;
+
+    assign rd_resp_val = !buf_empty || mem_rd_resp_val;
+    assign rd_resp_data = buf_empty ? mem_rd_resp_data : buf_data[buf_head];
+
+    always_comb begin
+        buf_count_next = buf_count;
+        if (buf_push && !buf_pop) begin
+            buf_count_next = buf_count + 1'b1;
+        end
+        else if (!buf_push && buf_pop) begin
+            buf_count_next = buf_count - 1'b1;
+        end
+    end
+
+    always_comb begin
+        in_flight_next = in_flight;
+        if (mem_rd_req_val && !mem_rd_resp_val) begin
+            in_flight_next = in_flight + 1'b1;
+        end
+        else if (!mem_rd_req_val && mem_rd_resp_val) begin
+            in_flight_next = in_flight - 1'b1;
+        end
+    end
+
+    assign used_next = {1'b0, buf_count_next} + {1'b0, in_flight_next};
+
+    always_ff @(posedge clk) begin
+        if (rst) begin
+            buf_head <= '0;
+            buf_tail <= '0;
+            buf_count <= '0;
+            in_flight <= '0;
+            rd_req_rdy_reg <= 1'b0;
+        end
+        else begin
+            if (buf_push) begin
+                buf_tail <= (buf_tail == PTR_W'(BUF_DEPTH - 1)) ? '0 : buf_tail + 1'b1;
+            end
+            if (buf_pop) begin
+                buf_head <= (buf_head == PTR_W'(BUF_DEPTH - 1)) ? '0 : buf_head + 1'b1;
+            end
+            buf_count <= buf_count_next;
+            in_flight <= in_flight_next;
+            rd_req_rdy_reg <= used_next < (COUNT_W + 1)'(BUF_DEPTH);
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (buf_push) begin
+            buf_data[buf_tail] <= mem_rd_resp_data;
+        end
+    end
+
+    always_ff @(negedge clk) begin
+        assert (rst || !mem_rd_req_val || mem_rd_req_rdy) else begin
+            $error("Memory not ready for a read with rd_resp_rdy tied high\n");
+        end
+    end
+
+endmodule
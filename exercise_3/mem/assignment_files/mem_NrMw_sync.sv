@@ -0,0 +1,132 @@
+//
+// A synchronous memory with NUM_RD read ports and NUM_WR write ports, built
+// one of three ways, picked with IMPL:
+//
+//   0  replicated  a copy of the memory for each read port, all written
+//                  together. Every read goes in, but only one write a cycle
+//   1  lvt         a copy for each pair of a read port and a write port, and
+//                  a live value table of which write port last wrote each
+//                  address, which picks the copy a read comes from. Every
+//                  read and every write goes in
+//   2  banked      NUM_BANKS banks, interleaved on the low bits of the
+//                  address, each with one read and one write port. A bank
+//                  takes one read and one write a cycle
+//
+// Requests are val/rdy, and rdy may depend on the val and addr of the other
+// ports in the same cycle. Where requests compete, the lowest numbered port
+// goes first, and the others wait. A read's data comes back the cycle after
+// it's taken, with rd_resp_val, and there's no backpressure on it. It
+// includes every write taken up to and including the same edge; for writes
+// to one address on the same edge, the highest numbered port wins.
+//
+module mem_NrMw_sync #(
+     parameter DATA_W = -1
+    ,parameter NUM_ELS = -1
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter NUM_RD = 2
+    ,parameter NUM_WR = 2
+    ,parameter IMPL = 1
+    // Only for IMPL 2, a power of 2 from 2 up that divides NUM_ELS, less than
+    // NUM_ELS so each bank has more than one row
+    ,parameter NUM_BANKS = 4
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [NUM_WR-1:0]                wr_req_val
+    ,input  logic   [NUM_WR-1:0][ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [NUM_WR-1:0][DATA_W-1:0]    wr_req_data
+    ,output logic   [NUM_WR-1:0]                wr_req_rdy
+
+    ,input  logic   [NUM_RD-1:0]                rd_req_val
+    ,input  logic   [NUM_RD-1:0][ADDR_W-1:0]    rd_req_addr
+    ,output logic   [NUM_RD-1:0]                rd_req_rdy
+
+    ,output logic   [NUM_RD-1:0]                rd_resp_val
+    ,output logic   [NUM_RD-1:0][DATA_W-1:0]    rd_resp_data
+);
+
+    generate
+        if (IMPL == 0) begin : replicated
+            mem_NrMw_sync_replicated #(
+                 .DATA_W    (DATA_W )
+                ,.NUM_ELS   (NUM_ELS)
+                ,.ADDR_W    (ADDR_W )
+                ,.NUM_RD    (NUM_RD )
+                ,.NUM_WR    (NUM_WR )
+            ) mem (
+                 .clk   (clk    )
+                ,.rst   (rst    )
+
+                ,.wr_req_val    (wr_req_val     )
+                ,.wr_req_addr   (wr_req_addr    )
+                ,.wr_req_data   (wr_req_data    )
+                ,.wr_req_rdy    (wr_req_rdy     )
+
+                ,.rd_req_val    (rd_req_val     )
+                ,.rd_req_addr   (rd_req_addr    )
+                ,.rd_req_rdy    (rd_req_rdy     )
+
+                ,.rd_resp_val   (rd_resp_val    )
+                ,.rd_resp_data  (rd_resp_data   )
+            );
+        end
+        else if (IMPL == 1) begin : lvt
+            mem_NrMw_sync_lvt #(
+                 .DATA_W    (DATA_W )
+                ,.NUM_ELS   (NUM_ELS)
+                ,.ADDR_W    (ADDR_W )
+                ,.NUM_RD    (NUM_RD )
+                ,.NUM_WR    (NUM_WR )
+            ) mem (
+                 .clk   (clk    )
+                ,.rst   (rst    )
+
+                ,.wr_req_val    (wr_req_val     )
+                ,.wr_req_addr   (wr_req_addr    )
+                ,.wr_req_data   (wr_req_data    )
+                ,.wr_req_rdy    (wr_req_rdy     )
+
+                ,.rd_req_val    (rd_req_val     )
+                ,.rd_req_addr   (rd_req_addr    )
+                ,.rd_req_rdy    (rd_req_rdy     )
+
+                ,.rd_resp_val   (rd_resp_val    )
+                ,.rd_resp_data  (rd_resp_data   )
+            );
+        end
+        else begin : banked
+            if ((NUM_BANKS < 2) || ((NUM_BANKS & (NUM_BANKS - 1)) != 0)
+                    || ((NUM_ELS % NUM_BANKS) != 0) || (NUM_BANKS >= NUM_ELS)) begin : bad_banks
+                // Checked when elaborating, the bank is the low bits of the
+                // address and the row the rest, which has to be at least a bit
+                $error("NUM_BANKS %0d has to be a power of 2 from 2 up, below NUM_ELS %0d",
+                       NUM_BANKS, NUM_ELS);
+            end
+            mem_NrMw_sync_banked #(
+                 .DATA_W    (DATA_W     )
+                ,.NUM_ELS   (NUM_ELS    )
+                ,.ADDR_W    (ADDR_W     )
+                ,.NUM_RD    (NUM_RD     )
+                ,.NUM_WR    (NUM_WR     )
+                ,.NUM_BANKS (NUM_BANKS  )
+            ) mem (
+                 .clk   (clk    )
+                ,.rst   (rst    )
+
+                ,.wr_req_val    (wr_req_val     )
+                ,.wr_req_addr   (wr_req_addr    )
+                ,.wr_req_data   (wr_req_data    )
+                ,.wr_req_rdy    (wr_req_rdy     )
+
+                ,.rd_req_val    (rd_req_val     )
+                ,.rd_req_addr   (rd_req_addr    )
+                ,.rd_req_rdy    (rd_req_rdy     )
+
+                ,.rd_resp_val   (rd_resp_val    )
+                ,.rd_resp_data  (rd_resp_data   )
+            );
+        end
+    endgenerate
+
+endmodule
@@ -0,0 +1,93 @@
+//
+// mem_NrMw_sync in NUM_BANKS banks, with consecutive addresses in consecutive
+// banks. Each bank takes one read and one write a cycle, so ports only wait
+// when they go to the same bank as a lower numbered port of the same kind
+//
+module mem_NrMw_sync_banked #(
+     parameter DATA_W = -1
+    ,parameter NUM_ELS = -1
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter NUM_RD = -1
+    ,parameter NUM_WR = -1
+    ,parameter NUM_BANKS = -1
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [NUM_WR-1:0]                wr_req_val
+    ,input  logic   [NUM_WR-1:0][ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [NUM_WR-1:0][DATA_W-1:0]    wr_req_data
+    ,output logic   [NUM_WR-1:0]                wr_req_rdy
+
+    ,input  logic   [NUM_RD-1:0]                rd_req_val
+    ,input  logic   [NUM_RD-1:0][ADDR_W-1:0]    rd_req_addr
+    ,output logic   [NUM_RD-1:0]                rd_req_rdy
+
+    ,output logic   [NUM_RD-1:0]                rd_resp_val
+    ,output logic   [NUM_RD-1:0][DATA_W-1:0]    rd_resp_data
+);
+
+    localparam BANK_W = $clog2(NUM_BANKS);
+    localparam ROWS = NUM_ELS / NUM_BANKS;
+
+    logic   [DATA_W-1:0]    mem [NUM_BANKS-1:0][ROWS-1:0];
+
+    logic   [ADDR_W-1:0]    rd_addr_reg [NUM_RD-1:0];
+
+    // Banks already taken by a lower numbered port this cycle
+    logic   [NUM_BANKS-1:0] wr_banks_taken;
+    logic   [NUM_BANKS-1:0] rd_banks_taken;
+
+    always_comb begin
+        wr_banks_taken = '0;
+        for (int w = 0; w < NUM_WR; w++) begin
+            wr_req_rdy[w] = !wr_banks_taken[wr_req_addr[w][BANK_W-1:0]];
+            if (wr_req_val[w]) begin
+                wr_banks_taken[wr_req_addr[w][BANK_W-1:0]] = 1'b1;
+            end
+        end
+    end
+
+    always_comb begin
+        rd_banks_taken = '0;
+        for (int r = 0; r < NUM_RD; r++) begin
+            rd_req_rdy[r] = !rd_banks_taken[rd_req_addr[r][BANK_W-1:0]];
+            if (rd_req_val[r]) begin
+                rd_banks_taken[rd_req_addr[r][BANK_W-1:0]] = 1'b1;
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        for (int w = 0; w < NUM_WR; w++) begin
+            if (wr_req_val[w] && wr_req_rdy[w]) begin
+                mem[wr_req_addr[w][BANK_W-1:0]][wr_req_addr[w][ADDR_W-1:BANK_W]]
+                    <= wr_req_data[w];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            if (rd_req_val[r] && rd_req_rdy[r]) begin
+                rd_addr_reg[r] <= rd_req_addr[r];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (rst) begin
+            rd_resp_val <= '0;
+        end
+        else begin
+            rd_resp_val <= rd_req_val & rd_req_rdy;
+        end
+    end
+
+    always_comb begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            rd_resp_data[r] = mem[rd_addr_reg[r][BANK_W-1:0]][rd_addr_reg[r][ADDR_W-1:BANK_W]];
+        end
+    end
+
+endmodule
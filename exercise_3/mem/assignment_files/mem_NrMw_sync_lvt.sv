@@ -0,0 +1,76 @@
+//
+// mem_NrMw_sync with a live value table. Each write port writes a copy of the
+// memory for each read port, and the table remembers which write port wrote
+// each address last, so a read takes its data from that port's copy. Nothing
+// ever waits, at the cost of NUM_RD * NUM_WR copies and a table of registers
+//
+module mem_NrMw_sync_lvt #(
+     parameter DATA_W = -1
+    ,parameter NUM_ELS = -1
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter NUM_RD = -1
+    ,parameter NUM_WR = -1
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [NUM_WR-1:0]                wr_req_val
+    ,input  logic   [NUM_WR-1:0][ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [NUM_WR-1:0][DATA_W-1:0]    wr_req_data
+    ,output logic   [NUM_WR-1:0]                wr_req_rdy
+
+    ,input  logic   [NUM_RD-1:0]                rd_req_val
+    ,input  logic   [NUM_RD-1:0][ADDR_W-1:0]    rd_req_addr
+    ,output logic   [NUM_RD-1:0]                rd_req_rdy
+
+    ,output logic   [NUM_RD-1:0]                rd_resp_val
+    ,output logic   [NUM_RD-1:0][DATA_W-1:0]    rd_resp_data
+);
+
+    localparam LVT_W = (NUM_WR > 1) ? $clog2(NUM_WR) : 1;
+
+    logic   [DATA_W-1:0]    mem [NUM_WR-1:0][NUM_RD-1:0][NUM_ELS-1:0];
+    logic   [LVT_W-1:0]     lvt [NUM_ELS-1:0];
+
+    logic   [ADDR_W-1:0]    rd_addr_reg [NUM_RD-1:0];
+
+    assign wr_req_rdy = '1;
+    assign rd_req_rdy = '1;
+
+    // For writes to the same address on one edge, the last one here, from the
+    // highest numbered port, is the one the table keeps
+    always_ff @(posedge clk) begin
+        for (int w = 0; w < NUM_WR; w++) begin
+            if (wr_req_val[w]) begin
+                for (int r = 0; r < NUM_RD; r++) begin
+                    mem[w][r][wr_req_addr[w]] <= wr_req_data[w];
+                end
+                lvt[wr_req_addr[w]] <= LVT_W'(w);
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            if (rd_req_val[r]) begin
+                rd_addr_reg[r] <= rd_req_addr[r];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (rst) begin
+            rd_resp_val <= '0;
+        end
+        else begin
+            rd_resp_val <= rd_req_val;
+        end
+    end
+
+    always_comb begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            rd_resp_data[r] = mem[lvt[rd_addr_reg[r]]][r][rd_addr_reg[r]];
+        end
+    end
+
+endmodule
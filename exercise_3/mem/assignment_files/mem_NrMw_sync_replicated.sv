@@ -0,0 +1,79 @@
+//
+// mem_NrMw_sync with a copy of the memory for each read port. All the copies
+// take the same write, so only one write port gets in a cycle
+//
+module mem_NrMw_sync_replicated #(
+     parameter DATA_W = -1
+    ,parameter NUM_ELS = -1
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter NUM_RD = -1
+    ,parameter NUM_WR = -1
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [NUM_WR-1:0]                wr_req_val
+    ,input  logic   [NUM_WR-1:0][ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [NUM_WR-1:0][DATA_W-1:0]    wr_req_data
+    ,output logic   [NUM_WR-1:0]                wr_req_rdy
+
+    ,input  logic   [NUM_RD-1:0]                rd_req_val
+    ,input  logic   [NUM_RD-1:0][ADDR_W-1:0]    rd_req_addr
+    ,output logic   [NUM_RD-1:0]                rd_req_rdy
+
+    ,output logic   [NUM_RD-1:0]                rd_resp_val
+    ,output logic   [NUM_RD-1:0][DATA_W-1:0]    rd_resp_data
+);
+
+    logic   [DATA_W-1:0]    mem [NUM_RD-1:0][NUM_ELS-1:0];
+
+    logic   [ADDR_W-1:0]    rd_addr_reg [NUM_RD-1:0];
+
+    logic                   wr_val;
+    logic   [ADDR_W-1:0]    wr_addr;
+    logic   [DATA_W-1:0]    wr_data;
+
+    assign rd_req_rdy = '1;
+
+    // The lowest numbered write port with a request gets the write
+    always_comb begin
+        wr_val = 1'b0;
+        wr_addr = '0;
+        wr_data = '0;
+        for (int w = 0; w < NUM_WR; w++) begin
+            wr_req_rdy[w] = !wr_val;
+            if (wr_req_val[w] && !wr_val) begin
+                wr_val = 1'b1;
+                wr_addr = wr_req_addr[w];
+                wr_data = wr_req_data[w];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            if (wr_val) begin
+                mem[r][wr_addr] <= wr_data;
+            end
+            if (rd_req_val[r]) begin
+                rd_addr_reg[r] <= rd_req_addr[r];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (rst) begin
+            rd_resp_val <= '0;
+        end
+        else begin
+            rd_resp_val <= rd_req_val;
+        end
+    end
+
+    always_comb begin
+        for (int r = 0; r < NUM_RD; r++) begin
+            rd_resp_data[r] = mem[r][rd_addr_reg[r]];
+        end
+    end
+
+endmodule
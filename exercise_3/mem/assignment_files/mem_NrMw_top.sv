@@ -0,0 +1,52 @@
+`timescale 1ns/1ns
+module mem_NrMw_top #(
+     parameter DATA_W = 32
+    ,parameter NUM_ELS = 1024
+    ,parameter ADDR_W = $clog2(NUM_ELS)
+    ,parameter NUM_RD = 2
+    ,parameter NUM_WR = 2
+    ,parameter IMPL = 1
+    ,parameter NUM_BANKS = 4
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [NUM_WR-1:0]                wr_req_val
+    ,input  logic   [NUM_WR-1:0][ADDR_W-1:0]    wr_req_addr
+    ,input  logic   [NUM_WR-1:0][DATA_W-1:0]    wr_req_data
+    ,output logic   [NUM_WR-1:0]                wr_req_rdy
+
+    ,input  logic   [NUM_RD-1:0]                rd_req_val
+    ,input  logic   [NUM_RD-1:0][ADDR_W-1:0]    rd_req_addr
+    ,output logic   [NUM_RD-1:0]                rd_req_rdy
+
+    ,output logic   [NUM_RD-1:0]                rd_resp_val
+    ,output logic   [NUM_RD-1:0][DATA_W-1:0]    rd_resp_data
+);
+
+    mem_NrMw_sync #(
+         .DATA_W    (DATA_W     )
+        ,.NUM_ELS   (NUM_ELS    )
+        ,.ADDR_W    (ADDR_W     )
+        ,.NUM_RD    (NUM_RD     )
+        ,.NUM_WR    (NUM_WR     )
+        ,.IMPL      (IMPL       )
+        ,.NUM_BANKS (NUM_BANKS  )
+    ) mem (
+         .clk   (clk    )
+        ,.rst   (rst    )
+
+        ,.wr_req_val    (wr_req_val     )
+        ,.wr_req_addr   (wr_req_addr    )
+        ,.wr_req_data   (wr_req_data    )
+        ,.wr_req_rdy    (wr_req_rdy     )
+
+        ,.rd_req_val    (rd_req_val     )
+        ,.rd_req_addr   (rd_req_addr    )
+        ,.rd_req_rdy    (rd_req_rdy     )
+
+        ,.rd_resp_val   (rd_resp_val    )
+        ,.rd_resp_data  (rd_resp_data   )
+    );
+
+endmodule
@@ -0,0 +1,83 @@
+#ifndef MEM_PORTS_H
+#define MEM_PORTS_H
+
+#include <cstdint>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmem_wr_bypass_top.h"
+
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+
+// Must match the NUM_ELS and DATA_W parameters of mem_wr_bypass_top
+#ifndef MEM_NUM_ELS
+#define MEM_NUM_ELS 8
+#endif
+#ifndef MEM_DATA_W
+#define MEM_DATA_W 8
+#endif
+#define MEM_DATA_MASK ((MEM_DATA_W >= 64) ? ~0ULL : ((1ULL << MEM_DATA_W) - 1))
+
+// Binds the interfaces of mem_wr_bypass_top to the val/rdy driver and monitor
+struct MemWrReq {
+    uint64_t addr;
+    uint64_t data;
+};
+
+struct MemWrReqPort {
+    typedef MemWrReq Req;
+
+    static void drive(Vmem_wr_bypass_top *top, bool val, const MemWrReq &req) {
+        top->wr_req_val = val;
+        top->wr_req_addr = req.addr;
+        top->wr_req_data = req.data;
+    }
+
+    static bool rdy(Vmem_wr_bypass_top *top) {
+        return top->wr_req_rdy;
+    }
+};
+
+struct MemRdReqPort {
+    typedef uint64_t Req;
+
+    static void drive(Vmem_wr_bypass_top *top, bool val, const uint64_t &addr) {
+        top->rd_req_val = val;
+        top->rd_req_addr = addr;
+    }
+
+    static bool rdy(Vmem_wr_bypass_top *top) {
+        return top->rd_req_rdy;
+    }
+};
+
+struct MemRdRespPort {
+    typedef uint64_t Resp;
+
+    static void set_rdy(Vmem_wr_bypass_top *top, bool rdy) {
+        top->rd_resp_rdy = rdy;
+    }
+
+    static bool val(Vmem_wr_bypass_top *top) {
+        return top->rd_resp_val;
+    }
+
+    static uint64_t data(Vmem_wr_bypass_top *top) {
+        return top->rd_resp_data;
+    }
+
+    static void report_mismatch(uint64_t time, const uint64_t &expected,
+                                const uint64_t &actual) {
+        VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd data wrong. Expected: %" VL_PRI64 "x, \
+Actual: %" VL_PRI64 "x\n", time, expected, actual);
+    }
+};
+
+typedef ValRdyDriver<Vmem_wr_bypass_top, MemWrReqPort> MemWrDriver;
+typedef ValRdyDriver<Vmem_wr_bypass_top, MemRdReqPort> MemRdDriver;
+typedef ValRdyMonitor<Vmem_wr_bypass_top, MemRdRespPort> MemRdMonitor;
+
+#endif
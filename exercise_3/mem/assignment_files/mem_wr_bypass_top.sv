@@ -3,6 +3,9 @@ module mem_wr_bypass_top #(
      parameter DATA_W = 8
     ,parameter NUM_ELS = 8
     ,parameter ADDR_W = $clog2(NUM_ELS)
+    // 1 for mem_1r1w_sync_wr_bypass_skid, with SKID_DEPTH responses buffered
+    ,parameter SKID = 0
+    ,parameter SKID_DEPTH = 4
 )(
      input clk
     ,input rst
@@ -21,35 +24,61 @@ module mem_wr_bypass_top #(
     ,input  logic                   rd_resp_rdy
 );
 
-    mem_1r1w_sync_wr_bypass #(
-         .DATA_W    (DATA_W )
-        ,.NUM_ELS   (NUM_ELS)
-        ,.ADDR_W    (ADDR_W )
-    ) mem (
-         .clk   (clk    )
-        ,.rst   (rst    )
-    
-        ,.wr_req_val    (wr_req_val     )
-        ,.wr_req_addr   (wr_req_addr    )
-        ,.wr_req_data   (wr_req_data    )
-        ,.wr_req_rdy    (wr_req_rdy     )
-                                        
-        ,.rd_req_val    (rd_req_val     )
-        ,.rd_req_addr   (rd_req_addr    )
-        ,.rd_req_rdy    (rd_req_rdy     )
-                                        
-        ,.rd_resp_val   (rd_resp_val    )
-        ,.rd_resp_data  (rd_resp_data   )
-        ,.rd_resp_rdy   (rd_resp_rdy    )
-    );
+    generate
+        if (SKID) begin : skid
+            mem_1r1w_sync_wr_bypass_skid #(
+                 .DATA_W    (DATA_W     )
+                ,.NUM_ELS   (NUM_ELS    )
+                ,.ADDR_W    (ADDR_W     )
+                ,.BUF_DEPTH (SKID_DEPTH )
+            ) mem (
+                 .clk   (clk    )
+                ,.rst   (rst    )
+
+                ,.wr_req_val    (wr_req_val     )
+                ,.wr_req_addr   (wr_req_addr    )
+                ,.wr_req_data   (wr_req_data    )
+                ,.wr_req_rdy    (wr_req_rdy     )
+
+                ,.rd_req_val    (rd_req_val     )
+                ,.rd_req_addr   (rd_req_addr    )
+                ,.rd_req_rdy    (rd_req_rdy     )
+
+                ,.rd_resp_val   (rd_resp_val    )
+                ,.rd_resp_data  (rd_resp_data   )
+                ,.rd_resp_rdy   (rd_resp_rdy    )
+            );
+        end
+        else begin : plain
+            mem_1r1w_sync_wr_bypass #(
+                 .DATA_W    (DATA_W )
+                ,.NUM_ELS   (NUM_ELS)
+                ,.ADDR_W    (ADDR_W )
+            ) mem (
+                 .clk   (clk    )
+                ,.rst   (rst    )
+
+                ,.wr_req_val    (wr_req_val     )
+                ,.wr_req_addr   (wr_req_addr    )
+                ,.wr_req_data   (wr_req_data    )
+                ,.wr_req_rdy    (wr_req_rdy     )
+
+                ,.rd_req_val    (rd_req_val     )
+                ,.rd_req_addr   (rd_req_addr    )
+                ,.rd_req_rdy    (rd_req_rdy     )
+
+                ,.rd_resp_val   (rd_resp_val    )
+                ,.rd_resp_data  (rd_resp_data   )
+                ,.rd_resp_rdy   (rd_resp_rdy    )
+            );
+        end
+    endgenerate
    
     initial begin
-        if ($test$plusargs("trace") != 0) begin
-            $display("[%0t] Tracing to logs/vlt_dump.vcd...\n", $time);
-            $dumpfile("logs/vlt_dump.vcd");
-            $dumpvars();
+        // +quiet for harness modes that build a model per run, e.g. +reset_sweep
+        if (!$test$plusargs("quiet")) begin
+            $display("[%0t] Model running...\n", $time);
         end
-        $display("[%0t] Model running...\n", $time);
     end
 
 endmodule
@@ -0,0 +1,310 @@
+// For std::unique_ptr
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmem_NrMw_top.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Benchmark timing and JSON output
+#include "sim_bench.h"
+// Packed arrays of ports, which may be wider than 64 bits
+#include "sim_wide.h"
+
+#define CLOCK_HALF_CYCLE_NS 5
+#define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+#define CYCLE_TIMEOUT 64
+
+// Must match the parameters of mem_NrMw_top, the Makefile passes both
+#ifndef MP_IMPL
+#define MP_IMPL 1
+#endif
+#ifndef MP_NUM_RD
+#define MP_NUM_RD 2
+#endif
+#ifndef MP_NUM_WR
+#define MP_NUM_WR 2
+#endif
+#ifndef MP_NUM_ELS
+#define MP_NUM_ELS 1024
+#endif
+#ifndef MP_DATA_W
+#define MP_DATA_W 32
+#endif
+#ifndef MP_NUM_BANKS
+#define MP_NUM_BANKS 4
+#endif
+// field() and set_field() take at most 64 bits, one port's worth
+static_assert(MP_DATA_W <= 64, "MP_DATA_W over 64 bits isn't supported by the harness");
+#define MP_DATA_MASK ((MP_DATA_W >= 64) ? ~0ULL : ((1ULL << MP_DATA_W) - 1))
+
+static constexpr unsigned clog2(uint64_t n) {
+    return (n <= 1) ? 0 : 1 + clog2((n + 1) / 2);
+}
+
+#define MP_ADDR_W clog2(MP_NUM_ELS)
+// 32 bit words of each packed array of ports, like Verilator's VlWide
+#define MP_WORDS(width) (((width) + 31) / 32)
+
+typedef WideUint<MP_WORDS(MP_NUM_WR * MP_ADDR_W)> WrAddrs;
+typedef WideUint<MP_WORDS(MP_NUM_WR * MP_DATA_W)> WrDatas;
+typedef WideUint<MP_WORDS(MP_NUM_RD * MP_ADDR_W)> RdAddrs;
+typedef WideUint<MP_WORDS(MP_NUM_RD * MP_DATA_W)> RdDatas;
+
+static const char *impl_names[] = {"replicated", "lvt", "banked"};
+
+// Number of cycles per run, change with +bench_size
+#define MP_DEFAULT_SIZE 1000000
+// Percent of cycles each port starts a new request when it hasn't got one
+// waiting, +rd_load=N and +wr_load=N
+#define MP_DEFAULT_RD_LOAD 100
+#define MP_DEFAULT_WR_LOAD 50
+
+// Random traffic, set from the plusargs in main()
+struct MultiportConfig {
+    uint64_t seed;
+    uint64_t rd_load;
+    uint64_t wr_load;
+};
+
+// What the ports did, over all runs
+struct MultiportStats {
+    uint64_t cycles = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    // Cycles a port had a request that wasn't taken
+    uint64_t rd_stalls = 0;
+    uint64_t wr_stalls = 0;
+    uint64_t rd_port_stalls[MP_NUM_RD] = {};
+    uint64_t wr_port_stalls[MP_NUM_WR] = {};
+};
+
+static MultiportConfig config;
+static MultiportStats stats;
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    contextp->debug(0);
+
+    // Start the memory out as all zeroes, so the reference model doesn't have
+    // to be filled in first
+    contextp->randReset(0);
+}
+
+// Every port at once, each with a request of its own that it holds until it's
+// taken, and the reads checked against a reference
+static void run_workload(uint64_t size, BenchRun &run) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    init_context(contextp);
+    const std::unique_ptr<Vmem_NrMw_top> top{new Vmem_NrMw_top{contextp.get(), "TOP"}};
+    SimClock<Vmem_NrMw_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    top->wr_req_val = 0;
+    top->rd_req_val = 0;
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+    sim.cycle();
+    sim.half_cycle();
+
+    SimRand rand{config.seed};
+    std::vector<uint64_t> ref_mem(MP_NUM_ELS, 0);
+
+    // The request each port is holding, if any
+    bool wr_val[MP_NUM_WR] = {};
+    WrAddrs wr_addrs;
+    WrDatas wr_datas;
+    bool rd_val[MP_NUM_RD] = {};
+    RdAddrs rd_addrs;
+    // Reads taken on the last edge, and what they have to come back with
+    bool resp_due[MP_NUM_RD] = {};
+    uint64_t resp_data[MP_NUM_RD] = {};
+
+    uint64_t start_cycles = sim.cycles();
+    uint64_t start_evals = sim.evals();
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t idle_cycles = 0;
+
+    run.start();
+    for (uint64_t cycle = 0; cycle < size; cycle++) {
+        uint64_t val_bits = 0;
+        for (unsigned w = 0; w < MP_NUM_WR; w++) {
+            if (!wr_val[w] && rand.chance(config.wr_load, 100)) {
+                wr_val[w] = true;
+                wr_addrs.set_field(w * MP_ADDR_W, MP_ADDR_W, rand.below(MP_NUM_ELS));
+                wr_datas.set_field(w * MP_DATA_W, MP_DATA_W, rand.next() & MP_DATA_MASK);
+            }
+            val_bits |= (uint64_t)wr_val[w] << w;
+        }
+        top->wr_req_val = val_bits;
+        wide_to_port(top->wr_req_addr, wr_addrs);
+        wide_to_port(top->wr_req_data, wr_datas);
+
+        val_bits = 0;
+        for (unsigned r = 0; r < MP_NUM_RD; r++) {
+            if (!rd_val[r] && rand.chance(config.rd_load, 100)) {
+                rd_val[r] = true;
+                rd_addrs.set_field(r * MP_ADDR_W, MP_ADDR_W, rand.below(MP_NUM_ELS));
+            }
+            val_bits |= (uint64_t)rd_val[r] << r;
+        }
+        top->rd_req_val = val_bits;
+        wide_to_port(top->rd_req_addr, rd_addrs);
+
+        sim.half_cycle();
+
+        // Responses to the reads taken on the last edge
+        RdDatas rd_datas = wide_from_port<MP_WORDS(MP_NUM_RD * MP_DATA_W)>(top->rd_resp_data);
+        for (unsigned r = 0; r < MP_NUM_RD; r++) {
+            bool val = (top->rd_resp_val >> r) & 1;
+            if (val != resp_due[r]) {
+                VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd_resp_val[%u] is %d, expected %d\n",
+                        contextp->time(), r, val, resp_due[r]);
+                run.errors++;
+            }
+            else if (val && (rd_datas.field(r * MP_DATA_W, MP_DATA_W) != resp_data[r])) {
+                VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd data wrong on port %u. Expected: \
+%" VL_PRI64 "x, Actual: %" VL_PRI64 "x\n", contextp->time(), r, resp_data[r],
+                        rd_datas.field(r * MP_DATA_W, MP_DATA_W));
+                run.errors++;
+            }
+        }
+
+        // Handshakes on the coming edge. Writes go in first, in port order, so
+        // the highest numbered port wins an address, and reads on the same
+        // edge see them
+        bool progress = false;
+        for (unsigned w = 0; w < MP_NUM_WR; w++) {
+            if (!wr_val[w]) {
+                continue;
+            }
+            if ((top->wr_req_rdy >> w) & 1) {
+                ref_mem[wr_addrs.field(w * MP_ADDR_W, MP_ADDR_W)]
+                    = wr_datas.field(w * MP_DATA_W, MP_DATA_W);
+                wr_val[w] = false;
+                writes++;
+                progress = true;
+            }
+            else {
+                stats.wr_port_stalls[w]++;
+            }
+        }
+        for (unsigned r = 0; r < MP_NUM_RD; r++) {
+            resp_due[r] = rd_val[r] && ((top->rd_req_rdy >> r) & 1);
+            if (resp_due[r]) {
+                resp_data[r] = ref_mem[rd_addrs.field(r * MP_ADDR_W, MP_ADDR_W)];
+                rd_val[r] = false;
+                reads++;
+                progress = true;
+            }
+            else if (rd_val[r]) {
+                stats.rd_port_stalls[r]++;
+            }
+        }
+
+        sim.half_cycle();
+
+        bool waiting = false;
+        for (unsigned w = 0; w < MP_NUM_WR; w++) {
+            waiting = waiting || wr_val[w];
+        }
+        for (unsigned r = 0; r < MP_NUM_RD; r++) {
+            waiting = waiting || rd_val[r];
+        }
+        idle_cycles = (progress || !waiting) ? 0 : idle_cycles + 1;
+        if (idle_cycles == CYCLE_TIMEOUT) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: nothing moved for %d cycles\n",
+                    contextp->time(), CYCLE_TIMEOUT);
+            run.errors++;
+            break;
+        }
+    }
+    run.stop();
+
+    run.cycles = sim.cycles() - start_cycles;
+    run.evals = sim.evals() - start_evals;
+    run.transactions = reads + writes;
+    stats.cycles += run.cycles;
+    stats.reads += reads;
+    stats.writes += writes;
+    top->final();
+}
+
+static double ratio(uint64_t count, uint64_t total) {
+    return (total == 0) ? 0.0 : (double)count / (double)total;
+}
+
+static std::string format_double(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.4f", value);
+    return text;
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    const SimArgs args{argc, argv};
+    config.seed = args.u64("seed", 0);
+    config.rd_load = args.u64("rd_load", MP_DEFAULT_RD_LOAD);
+    config.wr_load = args.u64("wr_load", MP_DEFAULT_WR_LOAD);
+
+    SimBench bench{"mem_NrMw_top multiport", args, MP_DEFAULT_SIZE};
+    bench.add_build_info();
+    bench.add_info("impl", impl_names[MP_IMPL]);
+    bench.add_info("num_rd", std::to_string(MP_NUM_RD));
+    bench.add_info("num_wr", std::to_string(MP_NUM_WR));
+    bench.add_info("num_els", std::to_string(MP_NUM_ELS));
+    bench.add_info("data_w", std::to_string(MP_DATA_W));
+    if (MP_IMPL == 2) {
+        bench.add_info("num_banks", std::to_string(MP_NUM_BANKS));
+    }
+    bench.add_info("rd_load", std::to_string(config.rd_load));
+    bench.add_info("wr_load", std::to_string(config.wr_load));
+    bench.add_info("seed", std::to_string(config.seed));
+
+    bench.run(run_workload);
+
+    for (unsigned r = 0; r < MP_NUM_RD; r++) {
+        stats.rd_stalls += stats.rd_port_stalls[r];
+    }
+    for (unsigned w = 0; w < MP_NUM_WR; w++) {
+        stats.wr_stalls += stats.wr_port_stalls[w];
+    }
+    // A stall is a cycle a request waited, out of all the cycles requests
+    // were up
+    double ops_per_cycle = ratio(stats.reads + stats.writes, stats.cycles);
+    double rd_stall_rate = ratio(stats.rd_stalls, stats.rd_stalls + stats.reads);
+    double wr_stall_rate = ratio(stats.wr_stalls, stats.wr_stalls + stats.writes);
+    VL_PRINTF("%s %ur%uw: %.3f ops/cycle (%.3f reads, %.3f writes) of %u ports\n",
+            impl_names[MP_IMPL], MP_NUM_RD, MP_NUM_WR, ops_per_cycle,
+            ratio(stats.reads, stats.cycles), ratio(stats.writes, stats.cycles),
+            MP_NUM_RD + MP_NUM_WR);
+    VL_PRINTF("  conflict stalls: reads %.2f%%, writes %.2f%%\n", 100.0 * rd_stall_rate,
+            100.0 * wr_stall_rate);
+    for (unsigned r = 0; r < MP_NUM_RD; r++) {
+        VL_PRINTF("  rd port %u stalled %" VL_PRI64 "u cycles\n", r, stats.rd_port_stalls[r]);
+    }
+    for (unsigned w = 0; w < MP_NUM_WR; w++) {
+        VL_PRINTF("  wr port %u stalled %" VL_PRI64 "u cycles\n", w, stats.wr_port_stalls[w]);
+    }
+
+    bench.add_info("ops_per_cycle", format_double(ops_per_cycle));
+    bench.add_info("rd_stall_rate", format_double(rd_stall_rate));
+    bench.add_info("wr_stall_rate", format_double(wr_stall_rate));
+
+    return bench.report() ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 // For std::unique_ptr
 #include <memory>
 #include <cstdint>
+#include <vector>
 #include <cstdlib>
 
 // Include common routines
@@ -9,10 +10,53 @@
 // Include model header, generated from Verilating "top.v"
 #include "Vmem_wr_bypass_top.h"
 
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Waveform tracing
+#include "sim_trace.h"
+// Flight recorder for failures
+#include "sim_flight.h"
+// Binary event log
+#include "sim_log.h"
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Randomized reset sweep
+#include "sim_reset.h"
+// Bindings of the memory's ports to them
+#include "mem_ports.h"
+
 #define CLOCK_HALF_CYCLE_NS 5
 #define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+// Cycles the flight recorder keeps before and after a failure by default
+#define FLIGHT_DEFAULT_CYCLES 64
+#define FLIGHT_DEFAULT_POST 16
 #define MAX_CAPACITY 8
 #define CYCLE_TIMEOUT 8
+// Times each address is read in the back-to-back read test
+#define PIPELINED_PASSES 4
+// Cycles without a handshake before giving up on the back-to-back reads
+#define PIPELINED_TIMEOUT 64
+// Seeds and cycles after reset for +reset_sweep with no count
+#define RESET_SWEEP_SEEDS 4096
+#define RESET_SWEEP_CYCLES 16
+// Reads per duty cycle in the bandwidth sweep, unless +bandwidth_reads=N
+#define BANDWIDTH_READS 4096
+// Least reads per cycle the skid buffer has to keep up, in percent of the
+// rd_resp_rdy duty cycle
+#define BANDWIDTH_MIN_PERCENT 90
+
+// 1 when the model is built with SKID=1, mem_1r1w_sync_wr_bypass_skid in
+// front of the memory, buffering MEM_SKID_DEPTH responses
+#ifndef MEM_SKID
+#define MEM_SKID 0
+#endif
+#ifndef MEM_SKID_DEPTH
+#define MEM_SKID_DEPTH 4
+#endif
 
 static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
                          int argc,
@@ -25,6 +69,14 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
     // May be overridden by commandArgs argument parsing
     contextp->randReset(2);
 
+    // Random initial values depend on +seed=N, so each seed of a regression
+    // starts from a different power-on state
+    // May be overridden by commandArgs argument parsing, with +verilator+seed+N
+    const SimArgs args{argc, argv};
+    if (args.flag("seed")) {
+        contextp->randSeed(sim_verilator_seed(args.u64("seed", 0)));
+    }
+
     // Verilator must compute traced signals
     contextp->traceEverOn(true);
 
@@ -34,31 +86,76 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
 
 }
 
-static void time_step(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmem_wr_bypass_top> &top) {
-    contextp->timeInc(1);  // 1 timeprecision period passes...
-    top->eval();
+/*******************************************************************************
+ * Flight recorder, see sim_flight.h. +flight=N keeps the last N cycles of the
+ * ports and dumps them to logs/flight_*.vcd along with +flight_post=M cycles
+ * after each failure
+ ******************************************************************************/
+static const std::vector<FlightSignal> flight_signals = {
+    {"clk", 1},
+    {"rst", 1},
+    {"wr_req_val", 1},
+    {"wr_req_addr", 3},
+    {"wr_req_data", 8},
+    {"wr_req_rdy", 1},
+    {"rd_req_val", 1},
+    {"rd_req_addr", 3},
+    {"rd_req_rdy", 1},
+    {"rd_resp_val", 1},
+    {"rd_resp_data", 8},
+    {"rd_resp_rdy", 1}
+};
+
+static void flight_sample(const Vmem_wr_bypass_top *top, uint64_t *values) {
+    values[0] = top->clk;
+    values[1] = top->rst;
+    values[2] = top->wr_req_val;
+    values[3] = top->wr_req_addr;
+    values[4] = top->wr_req_data;
+    values[5] = top->wr_req_rdy;
+    values[6] = top->rd_req_val;
+    values[7] = top->rd_req_addr;
+    values[8] = top->rd_req_rdy;
+    values[9] = top->rd_resp_val;
+    values[10] = top->rd_resp_data;
+    values[11] = top->rd_resp_rdy;
 }
 
-static void half_clock_cycle(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmem_wr_bypass_top> &top) {
-    top->clk = !top->clk;
-    for (int i = 0; i < CLOCK_HALF_CYCLE_NS; i++) {
-        time_step(contextp, top);
+// Set in main() when the flight recorder is on
+static FlightRecorder<Vmem_wr_bypass_top> *flight = nullptr;
+// Failed checks, for the exit code
+static uint64_t check_errors = 0;
+
+// Every failed check comes through here
+static void flight_trigger(const char *reason) {
+    check_errors++;
+    if (flight != nullptr) {
+        flight->trigger(reason);
     }
 }
 
-static void clock_cycle(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmem_wr_bypass_top> &top) {
-    half_clock_cycle(contextp, top);
-    half_clock_cycle(contextp, top);
-}
+/*******************************************************************************
+ * Event log, see sim_log.h. The status lines are printed as they happen, or
+ * with +log go to logs/events.bin for sim_log_decode to print afterwards
+ ******************************************************************************/
+enum LogEvent {
+    LOG_STATUS
+};
+
+static const std::vector<SimLogEvent> log_events = {
+    {SIM_LOG_STATUS, "status", "[%" VL_PRI64 "d] wr_req_val: %d mem[%x] <- %hhx \
+rd_resp_val: %d, rd_resp_data: %hhx\n"}
+};
+
+// Set in main()
+static SimLog *event_log = nullptr;
 
 static void check_output(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vmem_wr_bypass_top> &top,
                         uint8_t expected_rd_data) {
     if (top->rd_resp_val == 0) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd resp not valid\n", contextp->time());
+        flight_trigger("rd resp not valid");
     }
     else {
         bool data_wrong = expected_rd_data != top->rd_resp_data;
@@ -66,6 +163,7 @@ static void check_output(const std::unique_ptr<VerilatedContext> &contextp,
             VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd data wrong. Expected: %hhx, \
 Actual: %hhx\n",
                     contextp->time(), expected_rd_data, top->rd_resp_data);
+            flight_trigger("rd data wrong");
         }
     }
 }
@@ -73,10 +171,135 @@ Actual: %hhx\n",
 static void print_status(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vmem_wr_bypass_top> &top) {
     // Read outputs
-    VL_PRINTF("[%" VL_PRI64 "d] wr_req_val: %d mem[%x] <- %hhx \
-rd_resp_val: %d, rd_resp_data: %hhx\n", 
-            contextp->time(), top->wr_req_val, top->wr_req_addr, top->wr_req_data,
-            top->rd_resp_val, top->rd_resp_data);
+    event_log->log(LOG_STATUS, contextp->time(), {top->wr_req_val, top->wr_req_addr,
+            top->wr_req_data, top->rd_resp_val, top->rd_resp_data});
+}
+
+/*******************************************************************************
+ * Back-to-back reads. The port bindings are in mem_ports.h
+ ******************************************************************************/
+// Set in main(). +perf reports the latency, stalls and occupancy of each run of
+// reads, +perf_hist every bucket of their histograms as well
+static bool perf_report = false;
+static bool perf_histograms = false;
+
+// Reads every address passes times with rd_req_val held high. rd_resp_rdy
+// drops stall_numerator out of stall_denominator cycles. Must be called right
+// after a rising edge
+static ValRdyRun run_reads(SimClock<Vmem_wr_bypass_top> &sim,
+                           const uint8_t *ref_mem, uint64_t passes,
+                           uint64_t stall_numerator, uint64_t stall_denominator) {
+    MemRdDriver driver{sim.top()};
+    MemRdMonitor monitor{sim.contextp(), sim.top()};
+    monitor.set_error_hook(flight_trigger);
+    monitor.set_backpressure(stall_numerator, stall_denominator, 0);
+
+    for (uint64_t pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < MAX_CAPACITY; i++) {
+            driver.push(i);
+            monitor.expect(ref_mem[i]);
+        }
+    }
+
+    ValRdyPerf perf;
+    ValRdyRun run = run_valrdy(sim, driver, monitor, PIPELINED_TIMEOUT,
+                               perf_report ? &perf : nullptr);
+    if (perf_report) {
+        perf.report("rd_req -> rd_resp", perf_histograms);
+    }
+    sim.top()->rd_resp_rdy = 1;
+    return run;
+}
+
+// Reads every address PIPELINED_PASSES times and reports how many reads per
+// cycle made it through
+static void do_pipelined_reads(SimClock<Vmem_wr_bypass_top> &sim,
+                               const uint8_t *ref_mem,
+                               uint64_t stall_numerator, uint64_t stall_denominator) {
+    uint64_t errors_before = check_errors;
+    ValRdyRun run = run_reads(sim, ref_mem, PIPELINED_PASSES, stall_numerator,
+                              stall_denominator);
+    VL_PRINTF("%" VL_PRI64 "u reads in %" VL_PRI64 "u cycles, %.3f per cycle, \
+%" VL_PRI64 "u errors\n",
+            run.transactions, run.cycles, run.per_cycle(), check_errors - errors_before);
+}
+
+/*******************************************************************************
+ * Read bandwidth. Reads go back to back while rd_resp_rdy is high for a given
+ * percent of cycles at random. The reader can't take more than one read for
+ * each cycle it was ready, so that's the most the memory can do. Without a
+ * buffer the memory only gets there by passing rd_resp_rdy through to
+ * rd_req_rdy, the skid buffer has to get within BANDWIDTH_MIN_PERCENT of it
+ * with rd_req_rdy from a flop
+ ******************************************************************************/
+static const uint64_t bandwidth_duty_cycles[] = {100, 90, 75, 50, 25};
+
+// Must be called right after a rising edge
+static void do_bandwidth_sweep(SimClock<Vmem_wr_bypass_top> &sim,
+                               const uint8_t *ref_mem, uint64_t reads) {
+    uint64_t passes = (reads + MAX_CAPACITY - 1) / MAX_CAPACITY;
+    VL_PRINTF("Read bandwidth, %" VL_PRI64 "u reads per rd_resp_rdy duty cycle, %s\n",
+            passes * MAX_CAPACITY,
+            MEM_SKID ? "skid buffer" : "no skid buffer");
+    for (uint64_t duty : bandwidth_duty_cycles) {
+        ValRdyRun run = run_reads(sim, ref_mem, passes, 100 - duty, 100);
+        // Against the cycles rd_resp_rdy was really high, which only average
+        // out to the duty cycle
+        double percent = (run.rdy_cycles == 0) ? 0.0
+                       : 100.0 * (double)run.transactions / (double)run.rdy_cycles;
+        VL_PRINTF("  rd_resp_rdy %3" VL_PRI64 "u%%: %" VL_PRI64 "u reads in %" VL_PRI64 "u \
+cycles, %.3f per cycle, %.1f%% of the %" VL_PRI64 "u cycles rd_resp_rdy was high\n",
+                duty, run.transactions, run.cycles, run.per_cycle(), percent, run.rdy_cycles);
+        if (MEM_SKID && (percent < BANDWIDTH_MIN_PERCENT)) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: read bandwidth under %d%% of the cycles \
+rd_resp_rdy was high\n", sim.contextp()->time(), BANDWIDTH_MIN_PERCENT);
+            flight_trigger("read bandwidth low");
+        }
+    }
+}
+
+/*******************************************************************************
+ * Reset sweep, see sim_reset.h. +reset_sweep=N resets N models with different
+ * random initial values, from +seed=S on, and reports the outputs that don't
+ * come out of reset the same way every time
+ ******************************************************************************/
+static const std::vector<ResetSignal> reset_signals = {
+    {"wr_req_rdy",   -1},
+    {"rd_req_rdy",   -1},
+    {"rd_resp_val",  -1},
+    {"rd_resp_data", 2}
+};
+
+// Same reset as main(), with nothing requested afterwards
+static void reset_mem(SimClock<Vmem_wr_bypass_top> &sim) {
+    Vmem_wr_bypass_top *top = sim.top();
+
+    MemWrReqPort::drive(top, false, {0, 0});
+    MemRdReqPort::drive(top, false, 0);
+    top->rd_resp_rdy = 1;
+
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+}
+
+static void reset_sample(const Vmem_wr_bypass_top *top, uint64_t *values) {
+    values[0] = top->wr_req_rdy;
+    values[1] = top->rd_req_rdy;
+    values[2] = top->rd_resp_val;
+    values[3] = top->rd_resp_data;
+}
+
+static int run_reset_sweep(const SimArgs &args) {
+    const ResetBench<Vmem_wr_bypass_top> bench = {reset_mem, reset_sample};
+    ResetSweep sweep{reset_signals, args.u64("reset_cycles", RESET_SWEEP_CYCLES)};
+    size_t diverged = sweep.run(bench, args.u64("seed", 0),
+            args.u64("reset_sweep", RESET_SWEEP_SEEDS), (unsigned)args.u64("shards", 0),
+            CLOCK_HALF_CYCLE_NS);
+    sweep.report("mem_wr_bypass_top");
+    return (diverged == 0) ? 0 : 1;
 }
 
 int main(int argc, char** argv, char** env) {
@@ -91,6 +314,13 @@ int main(int argc, char** argv, char** env) {
     const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
     
     init_context(contextp, argc, argv);
+
+    const SimArgs args{argc, argv};
+
+    // Builds its own models, so it doesn't need the one below
+    if (args.flag("reset_sweep")) {
+        return run_reset_sweep(args);
+    }
     
     // Construct the Verilated model, from Vmux_sim_top.h generated from
     // Verilating "log_counter_top".  
@@ -98,9 +328,33 @@ int main(int argc, char** argv, char** env) {
     const std::unique_ptr<Vmem_wr_bypass_top> top{
                                         new Vmem_wr_bypass_top{contextp.get(), "TOP"}};
 
+    // Only evaluates the model on clock edges
+    SimClock<Vmem_wr_bypass_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    // Waveforms with +trace, see sim_trace.h for the options
+    SimTrace<Vmem_wr_bypass_top> trace{contextp.get(), top.get(), args};
+    trace.attach(sim);
+
+    // Keeps the last few cycles of the ports to dump around a failure
+    std::unique_ptr<FlightRecorder<Vmem_wr_bypass_top>> flight_recorder;
+    if (args.flag("flight")) {
+        flight_recorder.reset(new FlightRecorder<Vmem_wr_bypass_top>{sim, flight_signals,
+                flight_sample, args.u64("flight", FLIGHT_DEFAULT_CYCLES),
+                args.u64("flight_post", FLIGHT_DEFAULT_POST), "logs/flight"});
+        flight = flight_recorder.get();
+    }
+
+    // print_status() output
+    SimLog main_log{args, log_events};
+    event_log = &main_log;
+
+    perf_report = args.flag("perf") || args.flag("perf_hist");
+    perf_histograms = args.flag("perf_hist");
+
     uint64_t cycle_count;
 
-    std::srand(0);
+    // Different data for each +seed=N
+    std::srand((unsigned)args.u64("seed", 0));
     uint8_t ref_mem[MAX_CAPACITY];
 
     for (int i = 0; i < MAX_CAPACITY; i++) {
@@ -120,32 +374,33 @@ int main(int argc, char** argv, char** env) {
     top->clk = 0;
     top->rst = 1;
     
-    clock_cycle(contextp, top); // Kick the simulation
-    clock_cycle(contextp, top);
+    sim.cycle(); // Kick the simulation
+    sim.cycle();
     
     print_status(contextp, top);
     top->rst = 0;
-    clock_cycle(contextp, top);
+    sim.cycle();
     
     /***************************************************************************
      * Write some data
      **************************************************************************/
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     top->wr_req_val = 1;
     top->wr_req_addr = 0;
     top->wr_req_data = 0xab;
     ref_mem[0] = 0xab;
     print_status(contextp, top);
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     if (!(top->wr_req_rdy)) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: wr_req_rdy not high when it should be\n",
                     contextp->time());
+        flight_trigger("wr_req_rdy low");
     }
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     top->wr_req_val = 0;
-    clock_cycle(contextp, top);
+    sim.cycle();
 
     /***************************************************************************
      * Read some data
@@ -153,21 +408,22 @@ int main(int argc, char** argv, char** env) {
     top->rd_req_val = 1;
     top->rd_req_addr = 0;
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     if (!(top->rd_req_rdy)) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd_req_rdy not high when it should be\n",
                     contextp->time());
+        flight_trigger("rd_req_rdy low");
 
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
     top->rd_req_val = 0;
     // Tick half a clock cycle, so we can check the output
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     print_status(contextp, top);
     check_output(contextp, top, ref_mem[0]);
-    half_clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.half_cycle();
+    sim.cycle();
     /***************************************************************************
      * Write and then read data from all the possible addresses
      **************************************************************************/
@@ -179,35 +435,37 @@ int main(int argc, char** argv, char** env) {
         top->wr_req_data = ref_mem[i];
         print_status(contextp, top);
 
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
         if (!(top->wr_req_rdy)) {
             VL_PRINTF("[%" VL_PRI64 "d] ERROR: wr_req_rdy not high when it should be\n",
                     contextp->time());
+            flight_trigger("wr_req_rdy low");
         }
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
         top->wr_req_val = 0;
 
         top->rd_req_val = 1;
         top->rd_req_addr = i;
 
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
         if (!(top->rd_req_rdy)) {
             VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd_req_rdy not high when it should be\n",
                     contextp->time());
+            flight_trigger("rd_req_rdy low");
         }
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
 
         top->rd_req_val = 0;
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
         print_status(contextp, top);
         check_output(contextp, top, ref_mem[i]);
-        half_clock_cycle(contextp, top);
+        sim.half_cycle();
 
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
     
     /***************************************************************************
      * Check that write data bypasses correctly
@@ -221,55 +479,135 @@ int main(int argc, char** argv, char** env) {
     top->rd_req_val = 1;
     top->rd_req_addr = 0;
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     if (!(top->wr_req_rdy)) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: wr_req_rdy not high when it should be\n",
                     contextp->time());
+        flight_trigger("wr_req_rdy low");
     }
     if (!(top->rd_req_rdy)) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd_req_rdy not high when it should be\n",
                     contextp->time());
+        flight_trigger("rd_req_rdy low");
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
     top->rd_req_val = 0;
     top->wr_req_val = 0;
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     print_status(contextp, top);
     check_output(contextp, top, ref_mem[0]);
-    half_clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.half_cycle();
+    sim.cycle();
     
+    /***************************************************************************
+     * Check that reads can go back to back, with and without backpressure
+     **************************************************************************/
+    do_pipelined_reads(sim, ref_mem, 0, 0);
+    do_pipelined_reads(sim, ref_mem, 1, 2);
+    do_bandwidth_sweep(sim, ref_mem, args.u64("bandwidth_reads", BANDWIDTH_READS));
+    sim.cycle();
+
     /***************************************************************************
      * Check that you can backpressure rd resp
      **************************************************************************/
     // first check that if there is no valid response, we can set resp_rdy to 
     // low, but req_rdy is still high
     top->rd_resp_rdy = 0;
-    clock_cycle(contextp, top);
+    sim.cycle();
     
+#if MEM_SKID
+    // then check that reads are still taken while the responses wait, until
+    // the skid buffer has room for no more. rd_req_rdy comes from a flop, so
+    // rd_resp_rdy can't change it in between edges. Each read goes to the next
+    // address, so the responses show whether they come back in order
+    std::vector<int> taken_addrs;
+    top->rd_req_val = 1;
+    for (int i = 0; i < MEM_SKID_DEPTH + CYCLE_TIMEOUT; i++) {
+        top->rd_req_addr = (6 + taken_addrs.size()) % MAX_CAPACITY;
+        sim.half_cycle();
+        bool req_rdy = top->rd_req_rdy;
+        top->rd_resp_rdy = 1;
+        sim.eval();
+        bool req_rdy_resp_rdy = top->rd_req_rdy;
+        top->rd_resp_rdy = 0;
+        sim.eval();
+        if (req_rdy_resp_rdy != req_rdy) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd req rdy follows rd resp rdy\n",
+                    contextp->time());
+            flight_trigger("rd_req_rdy combinational");
+        }
+        if (!req_rdy) {
+            break;
+        }
+        taken_addrs.push_back(top->rd_req_addr);
+        sim.half_cycle();
+    }
+    if (taken_addrs.size() != MEM_SKID_DEPTH) {
+        VL_PRINTF("[%" VL_PRI64 "d] ERROR: %zu reads taken with rd resp rdy low, \
+expected %d\n", contextp->time(), taken_addrs.size(), MEM_SKID_DEPTH);
+        flight_trigger("rd_req_rdy wrong");
+    }
+    top->rd_req_val = 0;
+    sim.half_cycle();
+
+    // then every read taken comes back in order once rd_resp_rdy is high
+    top->rd_resp_rdy = 1;
+    for (int addr : taken_addrs) {
+        sim.half_cycle();
+        print_status(contextp, top);
+        check_output(contextp, top, ref_mem[addr]);
+        sim.half_cycle();
+    }
+    sim.half_cycle();
+    if (top->rd_resp_val == 1) {
+        VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd resp valid with no reads left\n",
+                contextp->time());
+        flight_trigger("rd_resp_val high");
+    }
+    sim.half_cycle();
+#else
     // then check that if there is a valid response and resp_rdy is low, then
     // req_rdy is also low
     top->rd_req_val = 1;
     top->rd_req_addr = 6;
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     if (top->rd_req_rdy != 1) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd req not ready\n", contextp->time());
+        flight_trigger("rd_req_rdy low");
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     print_status(contextp, top);
     if (top->rd_req_rdy == 1) {
         VL_PRINTF("[%" VL_PRI64 "d] ERROR: rd req ready, but shouldn't be\n",
                 contextp->time());
+        flight_trigger("rd_req_rdy high");
     }
     check_output(contextp, top, ref_mem[6]);
+#endif
+
+
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
+
+    VL_PRINTF("Simulated %" VL_PRI64 "u cycles with %" VL_PRI64 "u evals\n",
+            sim.cycles(), sim.evals());
+
+    if (flight != nullptr) {
+        flight->finish();
+    }
+
+    // Final model cleanup
+    top->final();
 
+    // Flush the rest of the trace
+    trace.close();
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    // Write out the rest of the event log
+    main_log.close();
 
-    return 0;
+    return (check_errors == 0) ? 0 : 1;
 }
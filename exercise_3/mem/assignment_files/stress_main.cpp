@@ -0,0 +1,279 @@
+// For std::unique_ptr
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// For getrusage
+#include <sys/resource.h>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmem_wr_bypass_top.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Benchmark timing and JSON output
+#include "sim_bench.h"
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Functional coverage
+#include "sim_cover.h"
+// Bindings of the memory's ports to them, and the size of the memory
+#include "mem_ports.h"
+
+#define CLOCK_HALF_CYCLE_NS 5
+#define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+#define CYCLE_TIMEOUT 64
+
+// Number of reads per run, change with +bench_size. A write goes in alongside
+// about every other read
+#define STRESS_DEFAULT_SIZE 4000000
+// Percent of reads that go to the address written in the same cycle, +collide=N
+#define STRESS_DEFAULT_COLLIDE 10
+// Percent of reads that go to the last address written, +reread=N
+#define STRESS_DEFAULT_REREAD 10
+// Percent of cycles rd_resp_rdy is low, +stall=N
+#define STRESS_DEFAULT_STALL 10
+// With +cover, each goal has to be hit this many times, and the run stops
+// after this many reads without covering anything new, +cover_plateau=N
+#define STRESS_COVER_GOAL 16
+#define STRESS_COVER_PLATEAU 100000
+
+// Random traffic, set from the plusargs in main()
+struct StressConfig {
+    uint64_t seed;
+    uint64_t collide;
+    uint64_t reread;
+    uint64_t stall;
+    bool cover;
+    uint64_t cover_plateau;
+    bool perf;
+};
+
+static StressConfig config;
+// Same-address reads and writes that went in on the same edge, over all runs
+static uint64_t total_collisions = 0;
+// Latency, stalls and occupancy of the reads, and the stalls of the writes,
+// over all runs, with +perf
+static ValRdyPerf rd_perf;
+static SimHistogram wr_stall;
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    contextp->debug(0);
+
+    // Start the memory out as all zeroes, so the reference model doesn't have
+    // to be filled in first, which would take NUM_ELS cycles
+    contextp->randReset(0);
+}
+
+static long max_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Random reads and writes all over the memory, with some of the reads aimed
+// at the address being written on the same edge or the one written last
+static void run_workload(uint64_t size, BenchRun &run) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    init_context(contextp);
+    const std::unique_ptr<Vmem_wr_bypass_top> top{
+                                        new Vmem_wr_bypass_top{contextp.get(), "TOP"}};
+    SimClock<Vmem_wr_bypass_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    top->wr_req_val = 0;
+    top->rd_req_val = 0;
+    top->rd_resp_rdy = 1;
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+    sim.cycle();
+    sim.half_cycle();
+
+    MemWrDriver wr_driver{top.get()};
+    MemRdDriver rd_driver{top.get()};
+    MemRdMonitor rd_monitor{contextp.get(), top.get()};
+    rd_monitor.set_backpressure(config.stall, 100, config.seed + 1);
+    SimRand rand{config.seed};
+    if (config.perf) {
+        rd_perf.attach(rd_driver, rd_monitor);
+        wr_driver.record_stalls(&wr_stall);
+    }
+
+    // On the heap, it's NUM_ELS * 8 bytes
+    std::vector<uint64_t> ref_mem(MEM_NUM_ELS, 0);
+    uint64_t last_wr_addr = 0;
+
+    // What the random traffic has got up to, with +cover
+    SimCoverage coverage{config.cover_plateau};
+    unsigned cover_bypass = coverage.add_goal("read bypassed a write", STRESS_COVER_GOAL);
+    unsigned cover_reread = coverage.add_goal("read of the last write", STRESS_COVER_GOAL);
+    unsigned cover_same_edge = coverage.add_goal("read and write on one edge",
+                                                 STRESS_COVER_GOAL);
+    unsigned cover_stall = coverage.add_goal("response held by rd_resp_rdy",
+                                             STRESS_COVER_GOAL);
+    unsigned cover_back_to_back = coverage.add_goal("reads on back to back edges",
+                                                    STRESS_COVER_GOAL);
+    bool read_last_edge = false;
+
+    uint64_t start_cycles = sim.cycles();
+    uint64_t start_evals = sim.evals();
+    uint64_t reads_queued = 0;
+    uint64_t idle_cycles = 0;
+    uint64_t collisions = 0;
+
+    run.start();
+    // Cut short once the coverage is done, with +cover
+    uint64_t reads_wanted = size;
+    while ((reads_queued < reads_wanted) || !rd_monitor.idle()) {
+        // One request per port at a time, so a write and a read queued together
+        // go out on the same edge unless one of them is stalled
+        if ((reads_queued < reads_wanted) && wr_driver.idle() && rd_driver.idle()) {
+            bool write = rand.chance(1, 2);
+            MemWrReq wr_req{rand.below(MEM_NUM_ELS), rand.next() & MEM_DATA_MASK};
+            uint64_t rd_addr = rand.below(MEM_NUM_ELS);
+            if (write && rand.chance(config.collide, 100)) {
+                rd_addr = wr_req.addr;
+            }
+            else if (rand.chance(config.reread, 100)) {
+                rd_addr = last_wr_addr;
+            }
+
+            if (write) {
+                wr_driver.push(wr_req);
+            }
+            rd_driver.push(rd_addr);
+            reads_queued++;
+        }
+
+        wr_driver.drive();
+        rd_driver.drive();
+        rd_monitor.drive();
+        sim.half_cycle();
+
+        // A write in the same cycle as a read to the same address is
+        // bypassed, so apply the write to the reference first
+        bool progress = false;
+        uint64_t prev_wr_addr = last_wr_addr;
+        bool wrote = wr_driver.sample();
+        if (wrote) {
+            last_wr_addr = wr_driver.last_sent().addr;
+            ref_mem[last_wr_addr] = wr_driver.last_sent().data;
+            progress = true;
+        }
+        bool read = rd_driver.sample();
+        if (read) {
+            uint64_t rd_addr = rd_driver.last_sent();
+            rd_monitor.expect(ref_mem[rd_addr]);
+            if (wrote && (rd_addr == last_wr_addr)) {
+                collisions++;
+            }
+            progress = true;
+        }
+        if (config.cover) {
+            if (read) {
+                uint64_t rd_addr = rd_driver.last_sent();
+                if (wrote) {
+                    coverage.hit(cover_same_edge);
+                    if (rd_addr == last_wr_addr) {
+                        coverage.hit(cover_bypass);
+                    }
+                }
+                else if (rd_addr == prev_wr_addr) {
+                    coverage.hit(cover_reread);
+                }
+                if (read_last_edge) {
+                    coverage.hit(cover_back_to_back);
+                }
+            }
+            if (top->rd_resp_val && !top->rd_resp_rdy) {
+                coverage.hit(cover_stall);
+            }
+            read_last_edge = read;
+        }
+        bool received = rd_monitor.sample();
+        progress = received || progress;
+        if (config.perf) {
+            rd_perf.cycle(read, received);
+        }
+        sim.half_cycle();
+
+        if (config.cover && read && coverage.done(reads_queued)) {
+            // Stop queueing, but let the reads in flight finish
+            reads_wanted = reads_queued;
+        }
+
+        idle_cycles = progress ? 0 : idle_cycles + 1;
+        if (idle_cycles == CYCLE_TIMEOUT) {
+            VL_PRINTF("[%" VL_PRI64 "d] ERROR: nothing moved for %d cycles\n",
+                    contextp->time(), CYCLE_TIMEOUT);
+            run.errors++;
+            break;
+        }
+    }
+    run.stop();
+
+    run.cycles = sim.cycles() - start_cycles;
+    run.evals = sim.evals() - start_evals;
+    run.transactions = rd_monitor.received() + wr_driver.sent();
+    run.errors += rd_monitor.errors();
+    total_collisions += collisions;
+    if (config.cover) {
+        coverage.report("Stress");
+    }
+    top->final();
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    const SimArgs args{argc, argv};
+    config.seed = args.u64("seed", 0);
+    config.collide = args.u64("collide", STRESS_DEFAULT_COLLIDE);
+    config.reread = args.u64("reread", STRESS_DEFAULT_REREAD);
+    config.stall = args.u64("stall", STRESS_DEFAULT_STALL);
+    config.cover = args.flag("cover");
+    config.cover_plateau = args.u64("cover_plateau", STRESS_COVER_PLATEAU);
+    // +perf_hist prints every bucket of the histograms too
+    config.perf = args.flag("perf") || args.flag("perf_hist");
+
+    SimBench bench{"mem_wr_bypass_top stress", args, STRESS_DEFAULT_SIZE};
+    bench.add_build_info();
+    bench.add_info("num_els", std::to_string(MEM_NUM_ELS));
+    bench.add_info("data_w", std::to_string(MEM_DATA_W));
+    bench.add_info("seed", std::to_string(config.seed));
+    long rss_before_kb = max_rss_kb();
+
+    bench.run(run_workload);
+
+    // Everything the model, the reference and the queues ever took at once
+    bench.add_info("max_rss_kb", std::to_string(max_rss_kb()));
+    bench.add_info("rss_before_model_kb", std::to_string(rss_before_kb));
+    bench.add_info("ref_mem_kb", std::to_string(MEM_NUM_ELS * sizeof(uint64_t) / 1024));
+    bench.add_info("collisions", std::to_string(total_collisions));
+    if (config.perf) {
+        rd_perf.report("rd_req -> rd_resp", args.flag("perf_hist"));
+        wr_stall.report("wr_req stall");
+        if (args.flag("perf_hist")) {
+            wr_stall.print("wr_req stall");
+        }
+        bench.add_info("rd_latency", rd_perf.latency.percentiles());
+        bench.add_info("rd_req_stall", rd_perf.req_stall.percentiles());
+        bench.add_info("rd_resp_stall", rd_perf.resp_stall.percentiles());
+        bench.add_info("rd_in_flight", rd_perf.occupancy.percentiles());
+        bench.add_info("wr_req_stall", wr_stall.percentiles());
+    }
+
+    return bench.report() ? 0 : 1;
+}
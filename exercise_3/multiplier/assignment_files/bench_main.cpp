@@ -0,0 +1,107 @@
+// For std::unique_ptr
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmultiplier_top.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Benchmark timing and JSON output
+#include "sim_bench.h"
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Bindings of the multiplier's ports to them
+#include "multiplier_ports.h"
+
+#define CLOCK_HALF_CYCLE_NS 5
+#define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+#define CYCLE_TIMEOUT 1024
+
+// Number of multiplies per run, change with +bench_size
+#define BENCH_DEFAULT_SIZE 100000
+
+// Latency, stalls and occupancy over all runs. Only kept with +perf, so the
+// plain benchmark times the same work as before
+static bool perf = false;
+static ValRdyPerf mul_perf;
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    contextp->debug(0);
+
+    // Randomization reset policy
+    contextp->randReset(2);
+}
+
+// Random multiplies sent back to back
+static void run_workload(uint64_t size, BenchRun &run) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    init_context(contextp);
+    const std::unique_ptr<Vmultiplier_top> top{new Vmultiplier_top{contextp.get(), "TOP"}};
+    SimClock<Vmultiplier_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    MulReqPort::drive(top.get(), false, {});
+    top->resp_rdy = 1;
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+    sim.cycle();
+    sim.half_cycle();
+
+    MulDriver driver{top.get()};
+    MulMonitor monitor{contextp.get(), top.get()};
+    SimRand rand{0};
+    std::vector<MulReq> reqs(size);
+    for (uint64_t i = 0; i < size; i++) {
+        reqs[i].operand_a = mul_random_operand(rand);
+        reqs[i].operand_b = mul_random_operand(rand);
+        driver.push(reqs[i]);
+    }
+    mul_expect_products(monitor, reqs);
+
+    uint64_t start_evals = sim.evals();
+
+    run.start();
+    ValRdyRun valrdy = run_valrdy(sim, driver, monitor, CYCLE_TIMEOUT,
+                                  perf ? &mul_perf : nullptr);
+    run.stop();
+
+    run.cycles = valrdy.cycles;
+    run.evals = sim.evals() - start_evals;
+    run.transactions = valrdy.transactions;
+    run.errors = monitor.errors();
+    top->final();
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    const SimArgs args{argc, argv};
+    SimBench bench{"multiplier_top", args, BENCH_DEFAULT_SIZE};
+    bench.add_info("operand_w", std::to_string(OPERAND_W));
+    bench.add_build_info();
+
+    perf = args.flag("perf");
+    bench.run(run_workload);
+
+    if (perf) {
+        bench.add_info("latency", mul_perf.latency.percentiles());
+        bench.add_info("req_stall", mul_perf.req_stall.percentiles());
+        bench.add_info("resp_stall", mul_perf.resp_stall.percentiles());
+        bench.add_info("in_flight", mul_perf.occupancy.percentiles());
+    }
+    return bench.report() ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#ifndef MULTIPLIER_PORTS_H
+#define MULTIPLIER_PORTS_H
+
+#include <cstdint>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vmultiplier_top.h"
+
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Operands and products of any width
+#include "sim_wide.h"
+
+// Must match the OPERAND_W parameter of multiplier_top
+#ifndef OPERAND_W
+#define OPERAND_W 8
+#endif
+#define OPERAND_MASK ((OPERAND_W >= 64) ? ~0ULL : ((1ULL << OPERAND_W) - 1))
+#define PRODUCT_W (2 * OPERAND_W)
+// Operands and products are kept as 32 bit words, like Verilator's VlWide, so
+// the harness works the same at any OPERAND_W
+#define OPERAND_WORDS ((OPERAND_W + 31) / 32)
+
+typedef WideUint<OPERAND_WORDS> MulOperand;
+typedef WideUint<2 * OPERAND_WORDS> MulProduct;
+
+static inline MulOperand mul_random_operand(SimRand &rand) {
+    return wide_random<OPERAND_WORDS>(rand, OPERAND_W);
+}
+
+// The reference for a single product. Use WideMulBatch for lots of them
+static inline MulProduct mul_reference(const MulOperand &a, const MulOperand &b) {
+    return wide_mul(a, b);
+}
+
+// Binds the request and response interfaces of multiplier_top to the val/rdy
+// driver and monitor
+struct MulReq {
+    MulOperand operand_a;
+    MulOperand operand_b;
+};
+
+struct MulReqPort {
+    typedef MulReq Req;
+
+    static void drive(Vmultiplier_top *top, bool val, const MulReq &req) {
+        top->req_val = val;
+        wide_to_port(top->req_operand_a, req.operand_a);
+        wide_to_port(top->req_operand_b, req.operand_b);
+    }
+
+    static bool rdy(Vmultiplier_top *top) {
+        return top->req_rdy;
+    }
+};
+
+struct MulRespPort {
+    typedef MulProduct Resp;
+
+    static void set_rdy(Vmultiplier_top *top, bool rdy) {
+        top->resp_rdy = rdy;
+    }
+
+    static bool val(Vmultiplier_top *top) {
+        return top->resp_val;
+    }
+
+    static MulProduct data(Vmultiplier_top *top) {
+        return wide_from_port<2 * OPERAND_WORDS>(top->resp_product);
+    }
+
+    static void report_mismatch(uint64_t time, const MulProduct &expected,
+                                const MulProduct &actual) {
+        VL_PRINTF("[%" VL_PRI64 "d] rd data wrong. Expected: %s, Actual: %s\n",
+                time, expected.hex().c_str(), actual.hex().c_str());
+    }
+};
+
+typedef ValRdyDriver<Vmultiplier_top, MulReqPort> MulDriver;
+typedef ValRdyMonitor<Vmultiplier_top, MulRespPort> MulMonitor;
+
+// Works out the products of reqs with the batched reference and queues them on
+// the monitor, in order
+static inline void mul_expect_products(MulMonitor &monitor, const std::vector<MulReq> &reqs) {
+    WideMulBatch<OPERAND_WORDS> reference{reqs.size()};
+    for (size_t i = 0; i < reqs.size(); i++) {
+        reference.set(i, reqs[i].operand_a, reqs[i].operand_b);
+    }
+    reference.run(reqs.size());
+    for (size_t i = 0; i < reqs.size(); i++) {
+        monitor.expect(reference.product(i));
+    }
+}
+
+#endif
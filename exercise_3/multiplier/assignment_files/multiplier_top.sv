@@ -32,11 +32,9 @@ module multiplier_top #(
     );
 
     initial begin
-        if ($test$plusargs("trace") != 0) begin
-            $display("[%0t] Tracing to logs/vlt_dump.vcd...\n", $time);
-            $dumpfile("logs/vlt_dump.vcd");
-            $dumpvars();
+        // +quiet for harness modes that build a model per run, e.g. +reset_sweep
+        if (!$test$plusargs("quiet")) begin
+            $display("[%0t] Model running...\n", $time);
         end
-        $display("[%0t] Model running...\n", $time);
     end
 endmodule
@@ -1,7 +1,9 @@
 // For std::unique_ptr
 #include <memory>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 // Include common routines
 #include <verilated.h>
@@ -9,9 +11,71 @@
 // Include model header, generated from Verilating "top.v"
 #include "Vmultiplier_top.h"
 
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Multithreaded sweeps
+#include "sim_shard.h"
+// Operands and products of any width
+#include "sim_wide.h"
+// Waveform tracing
+#include "sim_trace.h"
+// Flight recorder for failures
+#include "sim_flight.h"
+// Binary event log
+#include "sim_log.h"
+// Deferred checking
+#include "sim_batch.h"
+// Functional coverage
+#include "sim_cover.h"
+// Hang detection
+#include "sim_watchdog.h"
+// val/rdy drivers and monitors
+#include "sim_valrdy.h"
+// Bindings of the multiplier's ports to them
+#include "multiplier_ports.h"
+// Randomized reset sweep
+#include "sim_reset.h"
+
 #define CLOCK_HALF_CYCLE_NS 5
 #define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+// Cycles the flight recorder keeps before and after a failure by default
+#define FLIGHT_DEFAULT_CYCLES 64
+#define FLIGHT_DEFAULT_POST 16
 #define CYCLE_TIMEOUT 1024
+// Cycles without a handshake before the watchdog ends the run, change with
+// +watchdog=N. do_multiply() complains after CYCLE_TIMEOUT, so this leaves
+// room for the flight recorder to catch what comes after
+#define WATCHDOG_DEFAULT_CYCLES (4 * CYCLE_TIMEOUT)
+
+// Sweep every operand pair if there are at most 2^SWEEP_EXHAUSTIVE_BITS of
+// them, otherwise check every pair of corner cases, then +sweep_samples random
+// pairs
+#define SWEEP_EXHAUSTIVE_BITS 24
+#define SWEEP_EXHAUSTIVE (PRODUCT_W <= SWEEP_EXHAUSTIVE_BITS)
+#define SWEEP_DEFAULT_SAMPLES (1ULL << 20)
+#define SWEEP_CHUNK 256
+#define SWEEP_MAX_REPORTED 32
+
+// Number of random requests sent back to back
+#define PIPELINED_OPS 4096
+
+// Products per batch in +wide mode, and random pairs after the corner cases
+#define WIDE_BATCH 4096
+#define WIDE_DEFAULT_SAMPLES (1ULL << 20)
+// With +cover, +wide stops after this many products without covering anything
+// new, change with +cover_plateau
+#define WIDE_COVER_PLATEAU (1ULL << 16)
+
+// Seeds and cycles after reset for +reset_sweep with no count
+#define RESET_SWEEP_SEEDS 4096
+#define RESET_SWEEP_CYCLES 16
+
+// The flight recorder keeps at most 64 bits of each port
+#define FLIGHT_W(width) (((width) > 64) ? 64 : (width))
 
 static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
                          int argc,
@@ -24,6 +88,14 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
     // May be overridden by commandArgs argument parsing
     contextp->randReset(2);
 
+    // Random initial values depend on +seed=N, so each seed of a regression
+    // starts from a different power-on state
+    // May be overridden by commandArgs argument parsing, with +verilator+seed+N
+    const SimArgs args{argc, argv};
+    if (args.flag("seed")) {
+        contextp->randSeed(sim_verilator_seed(args.u64("seed", 0)));
+    }
+
     // Verilator must compute traced signals
     contextp->traceEverOn(true);
 
@@ -33,60 +105,117 @@ static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
 
 }
 
-static void time_step(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmultiplier_top> &top) {
-    contextp->timeInc(1);  // 1 timeprecision period passes...
-    top->eval();
+/*******************************************************************************
+ * Flight recorder, see sim_flight.h. +flight=N keeps the last N cycles of the
+ * ports and dumps them to logs/flight_*.vcd along with +flight_post=M cycles
+ * after each failure
+ ******************************************************************************/
+static const std::vector<FlightSignal> flight_signals = {
+    {"clk", 1},
+    {"rst", 1},
+    {"req_val", 1},
+    {"req_operand_a", FLIGHT_W(OPERAND_W)},
+    {"req_operand_b", FLIGHT_W(OPERAND_W)},
+    {"req_rdy", 1},
+    {"resp_val", 1},
+    {"resp_product", FLIGHT_W(PRODUCT_W)},
+    {"resp_rdy", 1}
+};
+
+static void flight_sample(const Vmultiplier_top *top, uint64_t *values) {
+    values[0] = top->clk;
+    values[1] = top->rst;
+    values[2] = top->req_val;
+    values[3] = wide_from_port<OPERAND_WORDS>(top->req_operand_a).low64();
+    values[4] = wide_from_port<OPERAND_WORDS>(top->req_operand_b).low64();
+    values[5] = top->req_rdy;
+    values[6] = top->resp_val;
+    values[7] = wide_from_port<2 * OPERAND_WORDS>(top->resp_product).low64();
+    values[8] = top->resp_rdy;
 }
 
-static void half_clock_cycle(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmultiplier_top> &top) {
-    top->clk = !top->clk;
-    for (int i = 0; i < CLOCK_HALF_CYCLE_NS; i++) {
-        time_step(contextp, top);
+// Set in main() when the flight recorder is on
+static FlightRecorder<Vmultiplier_top> *flight = nullptr;
+// Failed checks, for the exit code
+static uint64_t check_errors = 0;
+
+// Every failed check comes through here
+static void flight_trigger(const char *reason) {
+    check_errors++;
+    if (flight != nullptr) {
+        flight->trigger(reason);
     }
 }
 
-static void clock_cycle(const std::unique_ptr<VerilatedContext> &contextp,
-                    const std::unique_ptr<Vmultiplier_top> &top) {
-    half_clock_cycle(contextp, top);
-    half_clock_cycle(contextp, top);
-}
+/*******************************************************************************
+ * Watchdog, see sim_watchdog.h. Ends the run with a dump of the ports and exit
+ * code SIM_WATCHDOG_EXIT when neither interface has had a handshake for
+ * +watchdog=N cycles, +watchdog=0 to turn it off. +watchdog_trace=M writes the
+ * last M cycles to logs/watchdog_0.vcd as well
+ ******************************************************************************/
+static bool watch_req_val(const Vmultiplier_top *top) { return top->req_val; }
+static bool watch_req_rdy(const Vmultiplier_top *top) { return top->req_rdy; }
+static bool watch_resp_val(const Vmultiplier_top *top) { return top->resp_val; }
+static bool watch_resp_rdy(const Vmultiplier_top *top) { return top->resp_rdy; }
+
+static const std::vector<WatchPort<Vmultiplier_top>> watch_ports = {
+    {"req", watch_req_val, watch_req_rdy},
+    {"resp", watch_resp_val, watch_resp_rdy}
+};
+
+/*******************************************************************************
+ * Event log, see sim_log.h. The status lines are printed as they happen, or
+ * with +log go to logs/events.bin for sim_log_decode to print afterwards
+ ******************************************************************************/
+enum LogEvent {
+    LOG_STATUS
+};
+
+static const std::vector<SimLogEvent> log_events = {
+    {SIM_LOG_STATUS, "status", "[%" VL_PRI64 "d] req_val: %d A * B = %" VL_PRI64 "x * \
+%" VL_PRI64 "x rd_resp_val: %d, product: %" VL_PRI64 "x\n"}
+};
+
+// Set in main()
+static SimLog *event_log = nullptr;
 
 static void check_output(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vmultiplier_top> &top,
-                        uint16_t expected_product) {
+                        const MulProduct &expected_product) {
     if (top->resp_val == 0) {
         VL_PRINTF("[%" VL_PRI64 "d] resp not valid\n", contextp->time());
+        flight_trigger("resp not valid");
     }
     else {
-        bool data_wrong = expected_product != top->resp_product;
+        MulProduct actual_product = MulRespPort::data(top.get());
+        bool data_wrong = expected_product != actual_product;
         if (data_wrong) {
-            VL_PRINTF("[%" VL_PRI64 "d] rd data wrong. Expected: %hx, Actual: %hx\n",
-                    contextp->time(), expected_product, top->resp_product);
+            MulRespPort::report_mismatch(contextp->time(), expected_product,
+                                         actual_product);
+            flight_trigger("wrong product");
         }
     }
 }
 
 static void print_status(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vmultiplier_top> &top) {
-    // Read outputs
-    VL_PRINTF("[%" VL_PRI64 "d] req_val: %d A * B = %hhx * %hhx \
-rd_resp_val: %d, product: %hx\n", 
-            contextp->time(), top->req_val, top->req_operand_a, top->req_operand_b,
-            top->resp_val, top->resp_product);
+    // Read outputs. Only the low 64 bits of wide ports are logged
+    event_log->log(LOG_STATUS, contextp->time(), {top->req_val,
+            wide_from_port<OPERAND_WORDS>(top->req_operand_a).low64(),
+            wide_from_port<OPERAND_WORDS>(top->req_operand_b).low64(), top->resp_val,
+            MulRespPort::data(top.get()).low64()});
 }
 
 static void do_multiply(const std::unique_ptr<VerilatedContext> &contextp,
                         const std::unique_ptr<Vmultiplier_top> &top,
-                        uint8_t operand_a, uint8_t operand_b, uint64_t timeout_cycles) {
+                        SimClock<Vmultiplier_top> &sim,
+                        const MulOperand &operand_a, const MulOperand &operand_b,
+                        uint64_t timeout_cycles) {
     uint64_t cycle_count = 0;
 
-    top->req_val = 1;
-    top->req_operand_a = operand_a;
-    top->req_operand_b = operand_b;
+    MulReqPort::drive(top.get(), true, {operand_a, operand_b});
 
-    half_clock_cycle (contextp, top);
+    sim.half_cycle();
 
     cycle_count = 0;
     while (!top->req_rdy) {
@@ -94,27 +223,562 @@ static void do_multiply(const std::unique_ptr<VerilatedContext> &contextp,
         if (cycle_count == timeout_cycles) {
             VL_PRINTF("[%" VL_PRI64 "d] may have timed out waiting for req_rdy \
 to go high\n", contextp->time());
+            flight_trigger("timeout waiting for req_rdy");
         }
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
     top->req_val = 0;
     top->resp_rdy = 1;
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     cycle_count = 0;
     while (!top->resp_val) {
         cycle_count++;
         if (cycle_count == timeout_cycles) {
             VL_PRINTF("[%" VL_PRI64 "d] may have timed out waiting for resp_val \
 to go high\n", contextp->time());
+            flight_trigger("timeout waiting for resp_val");
+        }
+        sim.cycle();
+    }
+    check_output(contextp, top, mul_reference(operand_a, operand_b));
+    sim.half_cycle();
+    sim.cycle();
+}
+
+/*******************************************************************************
+ * Back-to-back requests
+ *
+ * Keeps req_val high for as long as there are requests queued and checks the
+ * products in order as they come out, so the multiplier runs as fast as its
+ * handshakes let it. The port bindings are in multiplier_ports.h.
+ ******************************************************************************/
+// Set in main(). +perf reports the latency, stalls and occupancy of the
+// back-to-back runs, +perf_hist every bucket of their histograms as well
+static bool perf_report = false;
+static bool perf_histograms = false;
+
+// Must be called right after a rising edge, like do_multiply()
+static void do_pipelined(SimClock<Vmultiplier_top> &sim,
+                         const std::vector<MulReq> &reqs) {
+    MulDriver driver{sim.top()};
+    MulMonitor monitor{sim.contextp(), sim.top()};
+    monitor.set_error_hook(flight_trigger);
+
+    for (const MulReq &req : reqs) {
+        driver.push(req);
+    }
+    mul_expect_products(monitor, reqs);
+
+    ValRdyPerf perf;
+    ValRdyRun run = run_valrdy(sim, driver, monitor, CYCLE_TIMEOUT,
+                               perf_report ? &perf : nullptr);
+    VL_PRINTF("%" VL_PRI64 "u products in %" VL_PRI64 "u cycles, \
+%.3f per cycle, %" VL_PRI64 "u errors\n",
+            run.transactions, run.cycles, run.per_cycle(), monitor.errors());
+    if (perf_report) {
+        perf.report("req -> resp", perf_histograms);
+    }
+}
+
+/*******************************************************************************
+ * Operand sweeps
+ *
+ * Every sweep below goes through the same sequence of operand pairs: all of
+ * them in order when there are few enough, otherwise every pair of corner
+ * cases from wide_corners() followed by random pairs. Pair i is the same
+ * whichever way the sweep is run, so a failure can be chased down with any of
+ * them.
+ ******************************************************************************/
+static const std::vector<MulOperand> &sweep_corners() {
+    static const std::vector<MulOperand> corners = wide_corners<OPERAND_WORDS>(OPERAND_W);
+    return corners;
+}
+
+static uint64_t sweep_num_ops(uint64_t num_samples) {
+#if SWEEP_EXHAUSTIVE
+    // Prevent unused variable warnings
+    if (false && num_samples) {}
+    return 1ULL << PRODUCT_W;
+#else
+    uint64_t num_corners = sweep_corners().size();
+    return num_corners * num_corners + num_samples;
+#endif
+}
+
+// Pair i of the sweep. rand must be the stream the random pairs come from and
+// is only used for those, so a chunk of the sweep can start at any i
+static void sweep_operands(uint64_t i, SimRand &rand,
+                           MulOperand &operand_a, MulOperand &operand_b) {
+#if SWEEP_EXHAUSTIVE
+    // Prevent unused variable warnings
+    if (false && rand.next()) {}
+    // Same order as the serial loop
+    operand_a = MulOperand{i >> OPERAND_W};
+    operand_b = MulOperand{i & OPERAND_MASK};
+#else
+    const std::vector<MulOperand> &corners = sweep_corners();
+    uint64_t num_corners = corners.size();
+    if (i < num_corners * num_corners) {
+        operand_a = corners[i / num_corners];
+        operand_b = corners[i % num_corners];
+    }
+    else {
+        operand_a = mul_random_operand(rand);
+        operand_b = mul_random_operand(rand);
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Sharded sweep
+ *
+ * Splits the operand space into chunks of SWEEP_CHUNK operations and runs them
+ * on worker threads, each with its own context and model. Every chunk writes
+ * into its own result slot and the slots are merged in chunk order, so the
+ * report is the same however the chunks got spread over the workers.
+ ******************************************************************************/
+struct SweepWorker {
+    std::unique_ptr<VerilatedContext> contextp;
+    std::unique_ptr<Vmultiplier_top> top;
+    std::unique_ptr<SimClock<Vmultiplier_top>> sim;
+    // Works out the products of a chunk before it's run
+    std::unique_ptr<WideMulBatch<OPERAND_WORDS>> reference;
+};
+
+struct SweepFailure {
+    MulOperand operand_a;
+    MulOperand operand_b;
+    MulProduct expected_product;
+    MulProduct actual_product;
+    bool timed_out;
+};
+
+struct SweepChunkResult {
+    uint64_t checked = 0;
+    uint64_t failed = 0;
+    uint64_t evals = 0;
+    uint64_t cycles = 0;
+    // Only the first SWEEP_MAX_REPORTED failures of each chunk are kept
+    std::vector<SweepFailure> failures;
+};
+
+// Puts the model through reset and leaves it in the clock phase do_multiply()
+// expects
+static void sweep_reset(SimClock<Vmultiplier_top> &sim) {
+    Vmultiplier_top *top = sim.top();
+
+    MulReqPort::drive(top, false, {});
+    top->resp_rdy = 1;
+
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+    sim.cycle();
+    sim.half_cycle();
+}
+
+static std::unique_ptr<SweepWorker> make_sweep_worker() {
+    std::unique_ptr<SweepWorker> worker{new SweepWorker};
+
+    // The workers don't get the command line, so only the main model acts on
+    // +trace and the workers don't all dump into the same file
+    worker->contextp.reset(new VerilatedContext);
+    worker->contextp->debug(0);
+    worker->contextp->randReset(2);
+
+    worker->top.reset(new Vmultiplier_top{worker->contextp.get(), "TOP"});
+    worker->sim.reset(new SimClock<Vmultiplier_top>{worker->contextp.get(),
+                                                    worker->top.get(),
+                                                    CLOCK_HALF_CYCLE_NS});
+    worker->reference.reset(new WideMulBatch<OPERAND_WORDS>{SWEEP_CHUNK});
+    sweep_reset(*worker->sim);
+    return worker;
+}
+
+// Same handshake as do_multiply(), but hands back the product instead of
+// checking it, and gives up if the design doesn't respond in time rather than
+// waiting forever on a worker thread
+static bool sweep_multiply(SimClock<Vmultiplier_top> &sim,
+                           const MulOperand &operand_a, const MulOperand &operand_b,
+                           uint64_t timeout_cycles, MulProduct &product) {
+    Vmultiplier_top *top = sim.top();
+    uint64_t cycle_count;
+
+    MulReqPort::drive(top, true, {operand_a, operand_b});
+
+    sim.half_cycle();
+
+    cycle_count = 0;
+    while (!top->req_rdy) {
+        cycle_count++;
+        if (cycle_count == timeout_cycles) {
+            return false;
         }
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
-    check_output(contextp, top, operand_a * operand_b);
-    half_clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.half_cycle();
+
+    top->req_val = 0;
+    top->resp_rdy = 1;
+
+    sim.half_cycle();
+    cycle_count = 0;
+    while (!top->resp_val) {
+        cycle_count++;
+        if (cycle_count == timeout_cycles) {
+            return false;
+        }
+        sim.cycle();
+    }
+    product = MulRespPort::data(top);
+    sim.half_cycle();
+    sim.cycle();
+    return true;
+}
+
+static void run_sweep_chunk(SweepWorker &worker, uint64_t chunk, uint64_t num_ops,
+                            uint64_t seed, SweepChunkResult &result) {
+    SimClock<Vmultiplier_top> &sim = *worker.sim;
+    WideMulBatch<OPERAND_WORDS> &reference = *worker.reference;
+    uint64_t start_evals = sim.evals();
+    uint64_t start_cycles = sim.cycles();
+
+    // Random operands are drawn from a stream of their own per chunk, so they
+    // don't depend on which worker runs the chunk
+    SimRand rand{seed, chunk};
+
+    uint64_t first = chunk * SWEEP_CHUNK;
+    uint64_t last = (first + SWEEP_CHUNK < num_ops) ? first + SWEEP_CHUNK : num_ops;
+    MulOperand operand_a[SWEEP_CHUNK];
+    MulOperand operand_b[SWEEP_CHUNK];
+    for (uint64_t i = first; i < last; i++) {
+        sweep_operands(i, rand, operand_a[i - first], operand_b[i - first]);
+        reference.set(i - first, operand_a[i - first], operand_b[i - first]);
+    }
+    reference.run(last - first);
+
+    for (uint64_t i = 0; i < last - first; i++) {
+        MulProduct expected_product = reference.product(i);
+        MulProduct actual_product;
+        bool done = sweep_multiply(sim, operand_a[i], operand_b[i], CYCLE_TIMEOUT,
+                                   actual_product);
+        result.checked++;
+        if (!done || (actual_product != expected_product)) {
+            result.failed++;
+            if (result.failures.size() < SWEEP_MAX_REPORTED) {
+                result.failures.push_back({operand_a[i], operand_b[i], expected_product,
+                                           actual_product, !done});
+            }
+            if (!done) {
+                // No telling what state it's in, so start it over
+                sweep_reset(sim);
+            }
+        }
+    }
+
+    result.evals = sim.evals() - start_evals;
+    result.cycles = sim.cycles() - start_cycles;
+}
+
+// Returns the number of failed operations
+static uint64_t run_sweep(unsigned num_workers, uint64_t num_samples, uint64_t seed) {
+    uint64_t num_ops = sweep_num_ops(num_samples);
+    uint64_t num_chunks = (num_ops + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+
+    std::vector<SweepChunkResult> results(num_chunks);
+
+    ShardStats stats = run_sharded<SweepWorker>(num_workers, num_chunks,
+        [](unsigned) {
+            return make_sweep_worker();
+        },
+        [&](SweepWorker &worker, uint64_t chunk) {
+            run_sweep_chunk(worker, chunk, num_ops, seed, results[chunk]);
+        });
+
+    uint64_t checked = 0;
+    uint64_t failed = 0;
+    uint64_t evals = 0;
+    uint64_t cycles = 0;
+    uint64_t reported = 0;
+    for (const SweepChunkResult &result : results) {
+        checked += result.checked;
+        failed += result.failed;
+        evals += result.evals;
+        cycles += result.cycles;
+        for (const SweepFailure &failure : result.failures) {
+            if (reported == SWEEP_MAX_REPORTED) {
+                break;
+            }
+            reported++;
+            if (failure.timed_out) {
+                VL_PRINTF("ERROR: %s * %s timed out\n",
+                        failure.operand_a.hex().c_str(), failure.operand_b.hex().c_str());
+            }
+            else {
+                VL_PRINTF("ERROR: %s * %s Expected: %s, Actual: %s\n",
+                        failure.operand_a.hex().c_str(), failure.operand_b.hex().c_str(),
+                        failure.expected_product.hex().c_str(),
+                        failure.actual_product.hex().c_str());
+            }
+        }
+    }
+    if (failed > reported) {
+        VL_PRINTF("... and %" VL_PRI64 "u more failures\n", failed - reported);
+    }
+
+    VL_PRINTF("Sharded sweep: %" VL_PRI64 "u %s products on %u workers, \
+%" VL_PRI64 "u chunks (%" VL_PRI64 "u stolen), %" VL_PRI64 "u cycles, \
+%" VL_PRI64 "u evals, %" VL_PRI64 "u failures\n",
+            checked, SWEEP_EXHAUSTIVE ? "exhaustive" : "corner and random", stats.workers,
+            stats.chunks, stats.stolen, cycles, evals, failed);
+    return failed;
+}
+
+/*******************************************************************************
+ * Deferred checking
+ *
+ * Runs the same operations as the sharded sweep on the main model, but only
+ * records the products as they come out. All the expected products are worked
+ * out and compared at the end in one pass, see sim_batch.h. BatchCheck keeps
+ * 64 bit samples, so this is only for products that fit in one; +wide does the
+ * same for any width.
+ ******************************************************************************/
+// Returns the number of failed operations, or 1 for products it can't check,
+// so nothing passes untested. Must be called right after a rising edge, like
+// do_multiply()
+static uint64_t run_batch(SimClock<Vmultiplier_top> &sim, uint64_t num_samples,
+                          uint64_t seed) {
+    if (PRODUCT_W > 64) {
+        VL_PRINTF("ERROR: Deferred checking only takes products of up to 64 bits, \
+use +wide for OPERAND_W %d\n", OPERAND_W);
+        return 1;
+    }
+
+    uint64_t num_ops = sweep_num_ops(num_samples);
+    std::vector<MulOperand> operand_a(num_ops);
+    std::vector<MulOperand> operand_b(num_ops);
+    SimRand rand{seed};
+    for (uint64_t i = 0; i < num_ops; i++) {
+        sweep_operands(i, rand, operand_a[i], operand_b[i]);
+    }
+
+    BatchCheck batch{num_ops};
+    for (uint64_t i = 0; i < num_ops; i++) {
+        MulProduct product;
+        bool done = sweep_multiply(sim, operand_a[i], operand_b[i], CYCLE_TIMEOUT,
+                                   product);
+        batch.record(sim.contextp()->time(), done, product.low64());
+        if (!done) {
+            // No telling what state it's in, so start it over
+            sweep_reset(sim);
+        }
+    }
+
+    WideMulBatch<OPERAND_WORDS> reference{num_ops};
+    for (uint64_t i = 0; i < num_ops; i++) {
+        reference.set(i, operand_a[i], operand_b[i]);
+    }
+    reference.run(num_ops);
+    uint64_t *expected = batch.expected();
+    for (uint64_t i = 0; i < num_ops; i++) {
+        expected[i] = reference.product(i).low64();
+    }
+
+    uint64_t failed = batch.check();
+    batch.report("product", SWEEP_MAX_REPORTED, [&operand_a, &operand_b](size_t i) {
+        VL_PRINTF("    for %s * %s\n", operand_a[i].hex().c_str(),
+                operand_b[i].hex().c_str());
+    });
+    return failed;
+}
+
+/*******************************************************************************
+ * Operand coverage, see sim_cover.h. Each operand falls into one of the
+ * classes below, and every pair of classes is a goal
+ ******************************************************************************/
+enum OperandClass {
+    OPERAND_ZERO,
+    OPERAND_ONE,
+    OPERAND_ALL_ONES,
+    // Only the top bit set
+    OPERAND_TOP_BIT,
+    // Some other single bit
+    OPERAND_POWER_OF_2,
+    // Top bit set and more
+    OPERAND_HIGH,
+    OPERAND_OTHER,
+    NUM_OPERAND_CLASSES
+};
+
+static const char *operand_class_names[NUM_OPERAND_CLASSES] = {
+    "zero", "one", "all ones", "top bit", "power of 2", "high", "other"
+};
+
+static OperandClass operand_class(const MulOperand &operand) {
+    unsigned bits_set = 0;
+    for (size_t i = 0; i < OPERAND_WORDS; i++) {
+        bits_set += __builtin_popcount(operand.words[i]);
+    }
+    bool top_bit = (operand.words[(OPERAND_W - 1) / 32] >> ((OPERAND_W - 1) % 32)) & 1;
+    if (bits_set == 0) {
+        return OPERAND_ZERO;
+    }
+    if (bits_set == OPERAND_W) {
+        return OPERAND_ALL_ONES;
+    }
+    if (bits_set == 1) {
+        if (operand.words[0] == 1) {
+            return OPERAND_ONE;
+        }
+        return top_bit ? OPERAND_TOP_BIT : OPERAND_POWER_OF_2;
+    }
+    return top_bit ? OPERAND_HIGH : OPERAND_OTHER;
+}
+
+struct OperandCoverage {
+    SimCoverage cover;
+    // Goal for each pair of classes, a's class * NUM_OPERAND_CLASSES + b's
+    unsigned pairs[NUM_OPERAND_CLASSES * NUM_OPERAND_CLASSES];
+
+    explicit OperandCoverage(uint64_t plateau)
+        : cover{plateau} {
+        for (unsigned a = 0; a < NUM_OPERAND_CLASSES; a++) {
+            for (unsigned b = 0; b < NUM_OPERAND_CLASSES; b++) {
+                pairs[a * NUM_OPERAND_CLASSES + b] = cover.add_goal(
+                        std::string{operand_class_names[a]} + " * " + operand_class_names[b]);
+            }
+        }
+    }
+
+    void sample(const MulReq &req) {
+        cover.hit(pairs[operand_class(req.operand_a) * NUM_OPERAND_CLASSES
+                        + operand_class(req.operand_b)]);
+    }
+};
+
+/*******************************************************************************
+ * Wide operands
+ *
+ * Sends the sweep's operand pairs back to back in batches of WIDE_BATCH. The
+ * expected products of each batch are worked out in one go by the reference in
+ * sim_wide.h, which is written so the compiler can vectorize it, so checking
+ * keeps up with the model as OPERAND_W grows.
+ ******************************************************************************/
+// Returns the number of failed operations. Must be called right after a rising
+// edge, like do_multiply(). With coverage, stops after the first batch where
+// coverage says it's done
+static uint64_t run_wide(SimClock<Vmultiplier_top> &sim, uint64_t num_samples,
+                         uint64_t seed, OperandCoverage *coverage) {
+    MulDriver driver{sim.top()};
+    MulMonitor monitor{sim.contextp(), sim.top()};
+    monitor.set_error_hook(flight_trigger);
+
+    uint64_t num_ops = sweep_num_ops(num_samples);
+    SimRand rand{seed};
+    std::vector<MulReq> reqs;
+    reqs.reserve(WIDE_BATCH);
+
+    ValRdyRun total;
+    ValRdyPerf perf;
+    std::chrono::duration<double> reference_time{0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < num_ops; first += WIDE_BATCH) {
+        uint64_t last = (first + WIDE_BATCH < num_ops) ? first + WIDE_BATCH : num_ops;
+        reqs.clear();
+        for (uint64_t i = first; i < last; i++) {
+            MulReq req;
+            sweep_operands(i, rand, req.operand_a, req.operand_b);
+            reqs.push_back(req);
+            driver.push(req);
+            if (coverage != nullptr) {
+                coverage->sample(req);
+            }
+        }
+
+        std::chrono::steady_clock::time_point reference_start =
+                std::chrono::steady_clock::now();
+        mul_expect_products(monitor, reqs);
+        reference_time += std::chrono::steady_clock::now() - reference_start;
+
+        ValRdyRun run = run_valrdy(sim, driver, monitor, CYCLE_TIMEOUT,
+                                   perf_report ? &perf : nullptr);
+        total.cycles += run.cycles;
+        total.transactions += run.transactions;
+        if (run.timed_out) {
+            break;
+        }
+        if ((coverage != nullptr) && coverage->cover.done(last)) {
+            break;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    VL_PRINTF("%" VL_PRI64 "u %d bit products in %" VL_PRI64 "u cycles, \
+%.3f per cycle, %.0f per second, %.1f%% of the time in the reference, \
+%" VL_PRI64 "u errors\n",
+            total.transactions, PRODUCT_W, total.cycles, total.per_cycle(),
+            total.transactions / elapsed.count(),
+            100.0 * reference_time.count() / elapsed.count(), monitor.errors());
+    if (perf_report) {
+        perf.report("req -> resp", perf_histograms);
+    }
+    if (coverage != nullptr) {
+        coverage->cover.report("Operand");
+    }
+    return monitor.errors();
+}
+
+/*******************************************************************************
+ * Reset sweep, see sim_reset.h. +reset_sweep=N resets N models with different
+ * random initial values, from +seed=S on, and reports the outputs that don't
+ * come out of reset the same way every time
+ ******************************************************************************/
+static const std::vector<ResetSignal> reset_signals = {
+    {"req_rdy",      -1},
+    {"resp_val",     -1},
+    {"resp_product", 1}
+};
+
+// Same reset as main(), with no request afterwards
+static void reset_multiplier(SimClock<Vmultiplier_top> &sim) {
+    Vmultiplier_top *top = sim.top();
+
+    MulReqPort::drive(top, false, {});
+    top->resp_rdy = 1;
+
+    top->clk = 0;
+    top->rst = 1;
+    sim.cycle();
+    sim.cycle();
+    top->rst = 0;
+}
+
+// Products wider than 64 bits are folded into 64, which is enough to tell
+// seeds apart
+static void reset_sample(const Vmultiplier_top *top, uint64_t *values) {
+    MulProduct product = wide_from_port<2 * OPERAND_WORDS>(top->resp_product);
+    uint64_t folded = 0;
+    for (size_t i = 0; i < 2 * OPERAND_WORDS; i++) {
+        folded ^= (uint64_t)product.words[i] << (32 * (i & 1));
+    }
+    values[0] = top->req_rdy;
+    values[1] = top->resp_val;
+    values[2] = folded;
+}
+
+static int run_reset_sweep(const SimArgs &args) {
+    const ResetBench<Vmultiplier_top> bench = {reset_multiplier, reset_sample};
+    ResetSweep sweep{reset_signals, args.u64("reset_cycles", RESET_SWEEP_CYCLES)};
+    size_t diverged = sweep.run(bench, args.u64("seed", 0),
+            args.u64("reset_sweep", RESET_SWEEP_SEEDS), (unsigned)args.u64("shards", 0),
+            CLOCK_HALF_CYCLE_NS);
+    sweep.report("multiplier_top");
+    return (diverged == 0) ? 0 : 1;
 }
 
 int main(int argc, char** argv, char** env) {
@@ -129,17 +793,62 @@ int main(int argc, char** argv, char** env) {
     const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
     
     init_context(contextp, argc, argv);
+
+    const SimArgs args{argc, argv};
+
+    // Builds its own models, so it doesn't need the one below
+    if (args.flag("reset_sweep")) {
+        return run_reset_sweep(args);
+    }
     
     // Construct the Verilated model, from Vmux_sim_top.h generated from
     // Verilating "log_counter_top".  
     // "TOP" will be the hierarchical name of the module.
     const std::unique_ptr<Vmultiplier_top> top{new Vmultiplier_top{contextp.get(), "TOP"}};
 
+    // Only evaluates the model on clock edges
+    SimClock<Vmultiplier_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    // Waveforms with +trace, see sim_trace.h for the options
+    SimTrace<Vmultiplier_top> trace{contextp.get(), top.get(), args};
+    trace.attach(sim);
+
+    // Keeps the last few cycles of the ports to dump around a failure
+    std::unique_ptr<FlightRecorder<Vmultiplier_top>> flight_recorder;
+    if (args.flag("flight")) {
+        flight_recorder.reset(new FlightRecorder<Vmultiplier_top>{sim, flight_signals,
+                flight_sample, args.u64("flight", FLIGHT_DEFAULT_CYCLES),
+                args.u64("flight_post", FLIGHT_DEFAULT_POST), "logs/flight"});
+        flight = flight_recorder.get();
+    }
+
+    // print_status() output
+    SimLog main_log{args, log_events};
+    event_log = &main_log;
+
+    perf_report = args.flag("perf") || args.flag("perf_hist");
+    perf_histograms = args.flag("perf_hist");
+
+    // Stops a design that never answers from hanging the run. Whatever is
+    // buffered goes out first
+    std::unique_ptr<SimWatchdog<Vmultiplier_top>> watchdog;
+    uint64_t watchdog_cycles = args.u64("watchdog", WATCHDOG_DEFAULT_CYCLES);
+    if (watchdog_cycles != 0) {
+        watchdog.reset(new SimWatchdog<Vmultiplier_top>{sim, watch_ports, flight_signals,
+                flight_sample, watchdog_cycles, args.u64("watchdog_trace", 0),
+                "logs/watchdog"});
+        watchdog->set_hang_hook([&]() {
+            if (flight != nullptr) {
+                flight->trigger("watchdog");
+                flight->finish();
+            }
+            trace.close();
+            main_log.close();
+        });
+    }
 
     // Set some initial data values
-    top->req_val = 0;
-    top->req_operand_a = 0;
-    top->req_operand_b = 0;
+    MulReqPort::drive(top.get(), false, {});
     
     top->resp_val = 0;
     top->resp_rdy = 1;
@@ -147,116 +856,184 @@ int main(int argc, char** argv, char** env) {
     top->clk = 0;
     top->rst = 1;
     
-    clock_cycle(contextp, top); // Kick the simulation
-    clock_cycle(contextp, top);
+    sim.cycle(); // Kick the simulation
+    sim.cycle();
     
     print_status(contextp, top);
     top->rst = 0;
-    clock_cycle(contextp, top);
+    sim.cycle();
     
     /***************************************************************************
      * Try just multiplying by 1
      **************************************************************************/
     printf("Run some basic test cases\n");
-    half_clock_cycle(contextp, top);
-    do_multiply(contextp, top, 4, 1, CYCLE_TIMEOUT);
+    sim.half_cycle();
+    do_multiply(contextp, top, sim, 4, 1, CYCLE_TIMEOUT);
     
     /***************************************************************************
      * Try just multiplying by 0
      **************************************************************************/
-    do_multiply(contextp, top, 4, 0, CYCLE_TIMEOUT);
+    do_multiply(contextp, top, sim, 4, 0, CYCLE_TIMEOUT);
     
     /***************************************************************************
      * Try flipping the operands
      **************************************************************************/
-    do_multiply(contextp, top, 1, 4, CYCLE_TIMEOUT);
-    do_multiply(contextp, top, 0, 4, CYCLE_TIMEOUT);
+    do_multiply(contextp, top, sim, 1, 4, CYCLE_TIMEOUT);
+    do_multiply(contextp, top, sim, 0, 4, CYCLE_TIMEOUT);
     
     /***************************************************************************
      * Test all the possible combinations
      **************************************************************************/
 
-    printf("Run exhaustive testing\n");
-    for (uint16_t a = 0; a <= (uint16_t)0xff; a++) {
-        for (uint16_t b = 0; b <= (uint16_t)0xff; b++) {
-            do_multiply(contextp, top, (uint8_t)a, (uint8_t)b, CYCLE_TIMEOUT);
+    // Failures the sweeps only count, rather than going through flight_trigger()
+    uint64_t sweep_failed = 0;
+    if (args.flag("shards")) {
+        // +shards=N runs the sweep on N threads, +shards or +shards=0 on
+        // all of the cores
+        unsigned num_workers = (unsigned)args.u64("shards", 0);
+        if (num_workers == 0) {
+            num_workers = default_shard_count();
+        }
+        printf("Run sharded exhaustive testing\n");
+        sweep_failed = run_sweep(num_workers,
+                                 args.u64("sweep_samples", SWEEP_DEFAULT_SAMPLES),
+                                 args.u64("seed", 0));
+    }
+    else if (args.flag("batch")) {
+        printf("Run exhaustive testing, checked at the end\n");
+        sweep_failed = run_batch(sim, args.u64("sweep_samples", SWEEP_DEFAULT_SAMPLES),
+                                 args.u64("seed", 0));
+    }
+    else if (args.flag("wide")) {
+        printf("Run wide operand testing\n");
+        // +cover stops once every pair of operand classes has been seen
+        std::unique_ptr<OperandCoverage> coverage;
+        if (args.flag("cover")) {
+            coverage.reset(new OperandCoverage{args.u64("cover_plateau",
+                                                        WIDE_COVER_PLATEAU)});
+        }
+        sweep_failed = run_wide(sim, args.u64("wide_samples", WIDE_DEFAULT_SAMPLES),
+                                args.u64("seed", 0), coverage.get());
+    }
+    else if (args.flag("pipelined")) {
+        printf("Run pipelined exhaustive testing\n");
+        uint64_t num_ops = sweep_num_ops(args.u64("sweep_samples", SWEEP_DEFAULT_SAMPLES));
+        SimRand rand{args.u64("seed", 0)};
+        std::vector<MulReq> reqs(num_ops);
+        for (uint64_t i = 0; i < num_ops; i++) {
+            sweep_operands(i, rand, reqs[i].operand_a, reqs[i].operand_b);
+        }
+        do_pipelined(sim, reqs);
+    }
+    else {
+        printf("Run exhaustive testing\n");
+        uint64_t num_ops = sweep_num_ops(args.u64("sweep_samples", SWEEP_DEFAULT_SAMPLES));
+        SimRand rand{args.u64("seed", 0)};
+        for (uint64_t i = 0; i < num_ops; i++) {
+            MulOperand operand_a;
+            MulOperand operand_b;
+            sweep_operands(i, rand, operand_a, operand_b);
+            do_multiply(contextp, top, sim, operand_a, operand_b, CYCLE_TIMEOUT);
         }
     }
     
+    /***************************************************************************
+     * Send requests back to back
+     **************************************************************************/
+    printf("Test back-to-back requests\n");
+    {
+        SimRand rand{args.u64("seed", 0)};
+        std::vector<MulReq> reqs;
+        for (int i = 0; i < PIPELINED_OPS; i++) {
+            MulOperand operand_a = mul_random_operand(rand);
+            reqs.push_back({operand_a, mul_random_operand(rand)});
+        }
+        do_pipelined(sim, reqs);
+    }
+
     /***************************************************************************
      * Make sure we can change the inputs while the request is in progress
      **************************************************************************/
     printf("Testing changing inputs while a request is in progress\n");
 
-    top->req_val = 1;
-    top->req_operand_a = 1;
-    top->req_operand_b = 10;
-    half_clock_cycle(contextp, top);
+    MulReqPort::drive(top.get(), true, {1, 10});
+    sim.half_cycle();
     while (!top->req_rdy) {
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
     top->req_val = 0;
     top->resp_rdy = 1;
-    clock_cycle(contextp, top);
-    top->req_val = 1;
-    top->req_operand_a = 0x32;
-    top->req_operand_b = 0x16;
+    sim.cycle();
+    MulReqPort::drive(top.get(), true, {0x32, 0x16});
 
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
     top->req_val = 0;
 
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     while (!top->resp_val) {
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
     check_output(contextp, top, 10 * 1);
-    half_clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.half_cycle();
+    sim.cycle();
     
     /***************************************************************************
      * Make sure we can backpressure the input
      **************************************************************************/
     printf("Test backpressuring the input\n"); 
 
-    top->req_val = 1;
-    top->req_operand_a = 15;
-    top->req_operand_b = 1;
+    MulReqPort::drive(top.get(), true, {15, 1});
     top->resp_rdy = 0;
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     
     while (!top->req_rdy) {
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
 
     while (!top->resp_val) {
-        clock_cycle(contextp, top);
+        sim.cycle();
     }
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
     if (top->req_rdy) {
         printf("Error: engine is ready for a request when it shouldn't be\n");
+        flight_trigger("req_rdy high");
     }
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
 
     // Try changing the inputs
-    top->req_val = 1;
-    top->req_operand_a = 0x54;
-    top->req_operand_b = 0x16;
-    clock_cycle(contextp, top);
-    half_clock_cycle(contextp, top);
+    MulReqPort::drive(top.get(), true, {0x54, 0x16});
+    sim.cycle();
+    sim.half_cycle();
     check_output(contextp, top, 15 * 1);
-    half_clock_cycle(contextp, top);
+    sim.half_cycle();
     top->req_val = 0;
     top->resp_rdy = 1;
-    clock_cycle(contextp, top);
+    sim.cycle();
     
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
-    clock_cycle(contextp, top);
+    sim.cycle();
+    sim.cycle();
+    sim.cycle();
+
+    VL_PRINTF("Simulated %" VL_PRI64 "u cycles with %" VL_PRI64 "u evals\n",
+            sim.cycles(), sim.evals());
+
+    if (flight != nullptr) {
+        flight->finish();
+    }
+
+    // Final model cleanup
+    top->final();
+
+    // Flush the rest of the trace
+    trace.close();
+
+    // Write out the rest of the event log
+    main_log.close();
 
-    return 0;
+    return ((check_errors == 0) && (sweep_failed == 0)) ? 0 : 1;
 }
 
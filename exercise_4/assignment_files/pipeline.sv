@@ -0,0 +1,85 @@
+import pipeline_pkg::*;
+module pipeline #(
+     parameter FORWARDING = 1
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [XLEN-1:0]  rst_pc
+
+    ,output logic               imem_req_val
+    ,output logic   [XLEN-1:0]  imem_req_addr
+    ,input  logic               imem_req_rdy
+
+    ,input  logic               imem_resp_val
+    ,input  logic   [XLEN-1:0]  imem_resp_data
+
+    ,output logic               dmem_req_val
+    ,output logic               dmem_req_wen
+    ,output logic   [XLEN-1:0]  dmem_req_addr
+    ,output logic   [XLEN-1:0]  dmem_req_wdata
+    ,input  logic               dmem_req_rdy
+
+    ,input  logic               dmem_resp_val
+    ,input  logic   [XLEN-1:0]  dmem_resp_rdata
+
+    ,output logic               retire_val
+    ,output logic   [XLEN-1:0]  retire_pc
+    ,output logic   [XLEN-1:0]  retire_inst
+    ,output logic               retire_rd_wen
+    ,output logic   [REG_ADDR_W-1:0]    retire_rd_addr
+    ,output logic   [XLEN-1:0]  retire_rd_data
+
+    ,output logic               perf_stall_data
+    ,output logic               perf_stall_ctrl
+    ,output logic               perf_stall_mem
+);
+
+    pipeline_datapath #(
+         .FORWARDING    (FORWARDING )
+    ) data (
+         .clk   (clk    )
+        ,.rst   (rst    )
+
+        ,.rst_pc            (rst_pc             )
+
+        ,.imem_req_addr     (imem_req_addr      )
+        ,.imem_resp_data    (imem_resp_data     )
+
+        ,.dmem_req_addr     (dmem_req_addr      )
+        ,.dmem_req_wdata    (dmem_req_wdata     )
+        ,.dmem_resp_rdata   (dmem_resp_rdata    )
+
+        ,.retire_pc         (retire_pc          )
+        ,.retire_inst       (retire_inst        )
+        ,.retire_rd_addr    (retire_rd_addr     )
+        ,.retire_rd_data    (retire_rd_data     )
+
+        /* TODO: add additional control signals here */
+    );
+
+    pipeline_ctrl #(
+         .FORWARDING    (FORWARDING )
+    ) ctrl (
+         .clk   (clk    )
+        ,.rst   (rst    )
+
+        ,.imem_req_val      (imem_req_val       )
+        ,.imem_req_rdy      (imem_req_rdy       )
+        ,.imem_resp_val     (imem_resp_val      )
+
+        ,.dmem_req_val      (dmem_req_val       )
+        ,.dmem_req_wen      (dmem_req_wen       )
+        ,.dmem_req_rdy      (dmem_req_rdy       )
+        ,.dmem_resp_val     (dmem_resp_val      )
+
+        ,.retire_val        (retire_val         )
+        ,.retire_rd_wen     (retire_rd_wen      )
+
+        ,.perf_stall_data   (perf_stall_data    )
+        ,.perf_stall_ctrl   (perf_stall_ctrl    )
+        ,.perf_stall_mem    (perf_stall_mem     )
+
+        /* TODO: add additional control signals here */
+    );
+endmodule
@@ -0,0 +1,36 @@
+import pipeline_pkg::*;
+module pipeline_ctrl #(
+     parameter FORWARDING = 1
+)(
+     input clk
+    ,input rst
+
+    ,output logic   imem_req_val
+    ,input  logic   imem_req_rdy
+    ,input  logic   imem_resp_val
+
+    ,output logic   dmem_req_val
+    ,output logic   dmem_req_wen
+    ,input  logic   dmem_req_rdy
+    ,input  logic   dmem_resp_val
+
+    ,output logic   retire_val
+    ,output logic   retire_rd_wen
+
+    ,output logic   perf_stall_data
+    ,output logic   perf_stall_ctrl
+    ,output logic   perf_stall_mem
+
+    // TODO: add in signals to/from datapath
+);
+
+    // TODO: fill in the valid bit of each stage, the stalls for hazards and
+    // memory requests that aren't ready, and the squashes for taken branches
+
+    // TODO: with FORWARDING, only stall decode when an operand comes from a
+    // load that hasn't got its data back yet, and pick the forwarding path
+    // for each operand. Without it, stall whenever an older instruction still
+    // in the pipeline writes an operand
+
+    // TODO: drive the perf_stall_* outputs from the stall and squash signals
+endmodule
@@ -0,0 +1,30 @@
+import pipeline_pkg::*;
+module pipeline_datapath #(
+     parameter FORWARDING = 1
+)(
+     input clk
+    ,input rst
+
+    ,input  logic   [XLEN-1:0]  rst_pc
+
+    ,output logic   [XLEN-1:0]  imem_req_addr
+    ,input  logic   [XLEN-1:0]  imem_resp_data
+
+    ,output logic   [XLEN-1:0]  dmem_req_addr
+    ,output logic   [XLEN-1:0]  dmem_req_wdata
+    ,input  logic   [XLEN-1:0]  dmem_resp_rdata
+
+    ,output logic   [XLEN-1:0]  retire_pc
+    ,output logic   [XLEN-1:0]  retire_inst
+    ,output logic   [REG_ADDR_W-1:0]    retire_rd_addr
+    ,output logic   [XLEN-1:0]  retire_rd_data
+
+    // TODO: add in signals to/from control
+);
+
+    // TODO: fill in the pc, the register file, decode, the adder and the
+    // pipeline registers between the stages
+
+    // TODO: with FORWARDING, mux each operand between the register file and
+    // the results further down the pipeline, as control selects
+endmodule
@@ -0,0 +1,117 @@
+#ifndef PIPELINE_ISA_H
+#define PIPELINE_ISA_H
+
+#include <cstdint>
+#include <cstdio>
+
+// The five RISC-V instructions of pipeline_pkg, for the harness to build
+// programs with:
+//   add   rd, rs1, rs2
+//   addi  rd, rs1, imm
+//   lw    rd, imm(rs1)
+//   sw    rs2, imm(rs1)
+//   bne   rs1, rs2, offset
+#define RV_OPC_OP       0x33
+#define RV_OPC_OP_IMM   0x13
+#define RV_OPC_LOAD     0x03
+#define RV_OPC_STORE    0x23
+#define RV_OPC_BRANCH   0x63
+
+#define RV_FUNCT3_ADD   0x0
+#define RV_FUNCT3_LW    0x2
+#define RV_FUNCT3_SW    0x2
+#define RV_FUNCT3_BNE   0x1
+
+#define RV_NUM_REGS 32
+
+static inline uint32_t rv_add(unsigned rd, unsigned rs1, unsigned rs2) {
+    return (rs2 << 20) | (rs1 << 15) | (RV_FUNCT3_ADD << 12) | (rd << 7) | RV_OPC_OP;
+}
+
+static inline uint32_t rv_addi(unsigned rd, unsigned rs1, int32_t imm) {
+    return ((uint32_t)(imm & 0xfff) << 20) | (rs1 << 15) | (RV_FUNCT3_ADD << 12)
+         | (rd << 7) | RV_OPC_OP_IMM;
+}
+
+static inline uint32_t rv_lw(unsigned rd, unsigned rs1, int32_t imm) {
+    return ((uint32_t)(imm & 0xfff) << 20) | (rs1 << 15) | (RV_FUNCT3_LW << 12)
+         | (rd << 7) | RV_OPC_LOAD;
+}
+
+static inline uint32_t rv_sw(unsigned rs2, unsigned rs1, int32_t imm) {
+    uint32_t bits = (uint32_t)imm;
+    return (((bits >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15)
+         | (RV_FUNCT3_SW << 12) | ((bits & 0x1f) << 7) | RV_OPC_STORE;
+}
+
+// offset is from the branch itself, and even
+static inline uint32_t rv_bne(unsigned rs1, unsigned rs2, int32_t offset) {
+    uint32_t bits = (uint32_t)offset;
+    return (((bits >> 12) & 0x1) << 31) | (((bits >> 5) & 0x3f) << 25) | (rs2 << 20)
+         | (rs1 << 15) | (RV_FUNCT3_BNE << 12) | (((bits >> 1) & 0xf) << 8)
+         | (((bits >> 11) & 0x1) << 7) | RV_OPC_BRANCH;
+}
+
+// Fields of an instruction
+static inline uint32_t rv_opcode(uint32_t inst) { return inst & 0x7f; }
+static inline unsigned rv_rd(uint32_t inst) { return (inst >> 7) & 0x1f; }
+static inline uint32_t rv_funct3(uint32_t inst) { return (inst >> 12) & 0x7; }
+static inline unsigned rv_rs1(uint32_t inst) { return (inst >> 15) & 0x1f; }
+static inline unsigned rv_rs2(uint32_t inst) { return (inst >> 20) & 0x1f; }
+static inline uint32_t rv_funct7(uint32_t inst) { return inst >> 25; }
+
+// Immediates, sign extended
+static inline int32_t rv_imm_i(uint32_t inst) { return (int32_t)inst >> 20; }
+
+static inline int32_t rv_imm_s(uint32_t inst) {
+    return (int32_t)(((int32_t)inst >> 25) * 32) | (int32_t)((inst >> 7) & 0x1f);
+}
+
+static inline int32_t rv_imm_b(uint32_t inst) {
+    return (int32_t)(((int32_t)inst >> 31) * 4096) | (int32_t)(((inst >> 7) & 0x1) << 11)
+         | (int32_t)(((inst >> 25) & 0x3f) << 5) | (int32_t)(((inst >> 8) & 0xf) << 1);
+}
+
+// Writes the assembly for inst to text, or ".word" for anything outside of
+// the five
+static inline void rv_disasm(uint32_t inst, char *text, size_t size) {
+    unsigned rd = rv_rd(inst);
+    unsigned rs1 = rv_rs1(inst);
+    unsigned rs2 = rv_rs2(inst);
+    uint32_t funct3 = rv_funct3(inst);
+    switch (rv_opcode(inst)) {
+    case RV_OPC_OP:
+        if ((funct3 == RV_FUNCT3_ADD) && (rv_funct7(inst) == 0)) {
+            std::snprintf(text, size, "add x%u, x%u, x%u", rd, rs1, rs2);
+            return;
+        }
+        break;
+    case RV_OPC_OP_IMM:
+        if (funct3 == RV_FUNCT3_ADD) {
+            std::snprintf(text, size, "addi x%u, x%u, %d", rd, rs1, rv_imm_i(inst));
+            return;
+        }
+        break;
+    case RV_OPC_LOAD:
+        if (funct3 == RV_FUNCT3_LW) {
+            std::snprintf(text, size, "lw x%u, %d(x%u)", rd, rv_imm_i(inst), rs1);
+            return;
+        }
+        break;
+    case RV_OPC_STORE:
+        if (funct3 == RV_FUNCT3_SW) {
+            std::snprintf(text, size, "sw x%u, %d(x%u)", rs2, rv_imm_s(inst), rs1);
+            return;
+        }
+        break;
+    case RV_OPC_BRANCH:
+        if (funct3 == RV_FUNCT3_BNE) {
+            std::snprintf(text, size, "bne x%u, x%u, %d", rs1, rs2, rv_imm_b(inst));
+            return;
+        }
+        break;
+    }
+    std::snprintf(text, size, ".word 0x%08x", inst);
+}
+
+#endif
@@ -0,0 +1,36 @@
+`timescale 1ns/1ns
+package pipeline_pkg;
+
+    localparam XLEN = 32;
+    localparam NUM_REGS = 32;
+    localparam REG_ADDR_W = $clog2(NUM_REGS);
+
+    // The five instructions the pipeline implements
+    //   add   rd, rs1, rs2
+    //   addi  rd, rs1, imm
+    //   lw    rd, imm(rs1)
+    //   sw    rs2, imm(rs1)
+    //   bne   rs1, rs2, offset
+    localparam logic [6:0] OPC_OP       = 7'b0110011;
+    localparam logic [6:0] OPC_OP_IMM   = 7'b0010011;
+    localparam logic [6:0] OPC_LOAD     = 7'b0000011;
+    localparam logic [6:0] OPC_STORE    = 7'b0100011;
+    localparam logic [6:0] OPC_BRANCH   = 7'b1100011;
+
+    localparam logic [2:0] FUNCT3_ADD   = 3'b000;
+    localparam logic [2:0] FUNCT3_LW    = 3'b010;
+    localparam logic [2:0] FUNCT3_SW    = 3'b010;
+    localparam logic [2:0] FUNCT3_BNE   = 3'b001;
+
+    typedef struct packed {
+        logic   [6:0]               funct7;
+        logic   [REG_ADDR_W-1:0]    rs2;
+        logic   [REG_ADDR_W-1:0]    rs1;
+        logic   [2:0]               funct3;
+        logic   [REG_ADDR_W-1:0]    rd;
+        logic   [6:0]               opcode;
+    } inst_r_s;
+
+    // TODO: add the types you need to pass state between the stages
+
+endpackage
@@ -0,0 +1,278 @@
+#ifndef PIPELINE_REF_H
+#define PIPELINE_REF_H
+
+#include <cinttypes>
+#include <cstdint>
+#include <deque>
+
+// Include common routines
+#include <verilated.h>
+
+// Program images in host memory
+#include "sim_image.h"
+// Encodings of the five instructions
+#include "pipeline_isa.h"
+
+// What one instruction did, as the reference model executed it
+struct RefRetire {
+    uint32_t pc;
+    uint32_t inst;
+    // Register write, never to x0
+    bool rd_wen;
+    unsigned rd;
+    uint32_t rd_data;
+    // Memory write
+    bool mem_wen;
+    uint32_t mem_addr;
+    uint32_t mem_data;
+};
+
+// Instruction set reference model of the five instructions, one instruction
+// at a time. It has its own copy of memory, so the pipeline's loads and
+// stores can't reach it
+class PipelineRef {
+  public:
+    // The tohost store doesn't go to memory, it's only reported
+    PipelineRef(SimImage &mem, uint32_t pc, uint32_t tohost)
+        : mem_(mem)
+        , pc_{pc}
+        , tohost_{tohost} {}
+
+    uint32_t pc() const { return pc_; }
+    uint32_t reg(unsigned r) const { return regs_[r]; }
+
+    // Executes the instruction at pc. Returns false with why in error for an
+    // instruction outside of the five or an access outside of memory
+    bool step(RefRetire &retire, const char *&error) {
+        retire.pc = pc_;
+        retire.inst = 0;
+        retire.rd_wen = false;
+        retire.mem_wen = false;
+        if (!aligned(pc_)) {
+            error = "fetch outside of memory or not word aligned";
+            return false;
+        }
+        uint32_t inst = *mem_.word(pc_);
+        retire.inst = inst;
+
+        unsigned rd = rv_rd(inst);
+        uint32_t a = regs_[rv_rs1(inst)];
+        uint32_t b = regs_[rv_rs2(inst)];
+        uint32_t funct3 = rv_funct3(inst);
+        uint32_t next_pc = pc_ + 4;
+        bool write = false;
+        uint32_t value = 0;
+
+        switch (rv_opcode(inst)) {
+        case RV_OPC_OP:
+            if ((funct3 != RV_FUNCT3_ADD) || (rv_funct7(inst) != 0)) {
+                error = "not one of the five instructions";
+                return false;
+            }
+            write = true;
+            value = a + b;
+            break;
+        case RV_OPC_OP_IMM:
+            if (funct3 != RV_FUNCT3_ADD) {
+                error = "not one of the five instructions";
+                return false;
+            }
+            write = true;
+            value = a + (uint32_t)rv_imm_i(inst);
+            break;
+        case RV_OPC_LOAD: {
+            uint32_t addr = a + (uint32_t)rv_imm_i(inst);
+            if (funct3 != RV_FUNCT3_LW) {
+                error = "not one of the five instructions";
+                return false;
+            }
+            if (!aligned(addr)) {
+                error = "load outside of memory or not word aligned";
+                return false;
+            }
+            write = true;
+            value = *mem_.word(addr);
+            break;
+        }
+        case RV_OPC_STORE: {
+            uint32_t addr = a + (uint32_t)rv_imm_s(inst);
+            if (funct3 != RV_FUNCT3_SW) {
+                error = "not one of the five instructions";
+                return false;
+            }
+            retire.mem_wen = true;
+            retire.mem_addr = addr;
+            retire.mem_data = b;
+            if (addr == tohost_) {
+                halted_ = true;
+            }
+            else if (!aligned(addr)) {
+                error = "store outside of memory or not word aligned";
+                return false;
+            }
+            else {
+                *mem_.word(addr) = b;
+            }
+            break;
+        }
+        case RV_OPC_BRANCH:
+            if (funct3 != RV_FUNCT3_BNE) {
+                error = "not one of the five instructions";
+                return false;
+            }
+            if (a != b) {
+                next_pc = pc_ + (uint32_t)rv_imm_b(inst);
+            }
+            break;
+        default:
+            error = "not one of the five instructions";
+            return false;
+        }
+
+        if (write && (rd != 0)) {
+            regs_[rd] = value;
+            retire.rd_wen = true;
+            retire.rd = rd;
+            retire.rd_data = value;
+        }
+        pc_ = next_pc;
+        return true;
+    }
+
+    // Whether the program has stored to tohost
+    bool halted() const { return halted_; }
+
+  private:
+    bool aligned(uint32_t addr) const {
+        return ((addr & 0x3) == 0) && mem_.in_range(addr, 4);
+    }
+
+    SimImage &mem_;
+    uint32_t regs_[RV_NUM_REGS] = {};
+    uint32_t pc_;
+    uint32_t tohost_;
+    bool halted_ = false;
+};
+
+/*******************************************************************************
+ * Lockstep co-simulation. Each instruction the pipeline retires is executed on
+ * the reference model, and only what it changed is compared: the pc and
+ * instruction, the register it writes and the store it makes, if any. Stores
+ * are compared as they reach the data memory, which is before they retire, so
+ * they're queued until then
+ ******************************************************************************/
+class PipelineCosim {
+  public:
+    PipelineCosim(SimImage &mem, uint32_t pc, uint32_t tohost)
+        : ref_{mem, pc, tohost} {}
+
+    // A store the pipeline sent to the data memory
+    void store(uint32_t addr, uint32_t data) {
+        stores_.push_back({addr, data});
+    }
+
+    // An instruction the pipeline retired. Returns false and prints what
+    // differs the first time the pipeline and the reference model disagree
+    bool retire(uint64_t cycle, uint32_t pc, uint32_t inst, bool rd_wen, unsigned rd,
+                uint32_t rd_data) {
+        if (diverged_) {
+            return false;
+        }
+        RefRetire want;
+        const char *error = nullptr;
+        if (!ref_.step(want, error)) {
+            report(cycle, want.pc, want.inst, "reference model", error);
+            return false;
+        }
+
+        char text[96];
+        if ((pc != want.pc) || (inst != want.inst)) {
+            char got[32];
+            rv_disasm(inst, got, sizeof(got));
+            std::snprintf(text, sizeof(text), "retired %08x %s instead", pc, got);
+            report(cycle, want.pc, want.inst, "pc", text);
+            return false;
+        }
+
+        // Writes to x0 may or may not show up on the ports, they don't count
+        bool writes = rd_wen && (rd != 0);
+        if ((writes != want.rd_wen)
+                || (want.rd_wen && ((rd != want.rd) || (rd_data != want.rd_data)))) {
+            if (!want.rd_wen) {
+                std::snprintf(text, sizeof(text), "expected no write, got x%u = %08x", rd, rd_data);
+            }
+            else if (!writes) {
+                std::snprintf(text, sizeof(text), "expected x%u = %08x, got no write", want.rd,
+                              want.rd_data);
+            }
+            else {
+                std::snprintf(text, sizeof(text), "expected x%u = %08x, got x%u = %08x", want.rd,
+                              want.rd_data, rd, rd_data);
+            }
+            report(cycle, pc, inst, "register write", text);
+            return false;
+        }
+
+        if (want.mem_wen) {
+            if (stores_.empty()) {
+                std::snprintf(text, sizeof(text), "expected mem[%08x] = %08x, it never reached \
+memory", want.mem_addr, want.mem_data);
+                report(cycle, pc, inst, "store", text);
+                return false;
+            }
+            Store got = stores_.front();
+            stores_.pop_front();
+            if ((got.addr != want.mem_addr) || (got.data != want.mem_data)) {
+                std::snprintf(text, sizeof(text), "expected mem[%08x] = %08x, got mem[%08x] = %08x",
+                              want.mem_addr, want.mem_data, got.addr, got.data);
+                report(cycle, pc, inst, "store", text);
+                return false;
+            }
+            stores_checked_++;
+        }
+        retired_++;
+        return true;
+    }
+
+    // Once the reference has retired the tohost store, every store the
+    // pipeline made has to have been matched
+    bool finished() const { return ref_.halted(); }
+
+    // Stores left over at the end were never retired
+    bool check_done(uint64_t cycle) {
+        if (diverged_ || stores_.empty()) {
+            return !diverged_;
+        }
+        VL_PRINTF("ERROR: %zu stores reached memory without retiring, by cycle %" VL_PRI64 "u, \
+the first mem[%08x] = %08x\n", stores_.size(), cycle, stores_.front().addr, stores_.front().data);
+        diverged_ = true;
+        return false;
+    }
+
+    bool diverged() const { return diverged_; }
+    uint64_t retired() const { return retired_; }
+    uint64_t stores_checked() const { return stores_checked_; }
+
+  private:
+    struct Store {
+        uint32_t addr;
+        uint32_t data;
+    };
+
+    void report(uint64_t cycle, uint32_t pc, uint32_t inst, const char *what, const char *detail) {
+        char text[32];
+        rv_disasm(inst, text, sizeof(text));
+        VL_PRINTF("ERROR: instruction %" VL_PRI64 "u diverged from the reference model on cycle \
+%" VL_PRI64 "u\n", retired_ + 1, cycle);
+        VL_PRINTF("  %08x  %-24s %s: %s\n", pc, text, what, detail);
+        diverged_ = true;
+    }
+
+    PipelineRef ref_;
+    std::deque<Store> stores_;
+    uint64_t retired_ = 0;
+    uint64_t stores_checked_ = 0;
+    bool diverged_ = false;
+};
+
+#endif
@@ -0,0 +1,110 @@
+`timescale 1ns/1ns
+import pipeline_pkg::*;
+// Do not modify the ports, the harness drives them
+//
+// Both memories answer a request the cycle after it's accepted
+// (req_val && req_rdy on a rising edge) with resp_val and the data, and the
+// pipeline has to take the response then. Stores get a response too, with no
+// data. The harness may hold req_rdy low to stall either memory.
+//
+// retire_val is high for one cycle for each instruction leaving writeback, in
+// program order, with its pc and the instruction itself. retire_rd_wen is high
+// with it when the instruction writes a register, with the register and the
+// value written, so the harness can check each one against a reference model
+// as it retires. Writes to x0 may go either way.
+//
+// FORWARDING picks how the pipeline handles an instruction that needs a
+// register an older one in the pipeline hasn't written yet: 1 forwards the
+// value from the later stages as soon as it's computed, 0 stalls in decode
+// until it's in the register file. Both have to work.
+//
+// The perf_stall_* outputs say why the pipeline lost a cycle, for the harness
+// to count:
+//   perf_stall_data    decode holds an instruction for an operand that isn't
+//                      ready yet, e.g. the result of a load
+//   perf_stall_ctrl    a bubble goes in behind a taken branch, in place of an
+//                      instruction fetched down the wrong path
+//   perf_stall_mem     the pipeline is held for a memory, req_rdy low or a
+//                      response still to come
+// At most one of them is high on a cycle, mem before data before ctrl, so
+// each lost cycle is counted once.
+module pipeline_top #(
+     parameter FORWARDING = 1
+)(
+     input clk
+    ,input rst
+
+    // Address of the first instruction, steady while rst is high
+    ,input  logic   [XLEN-1:0]  rst_pc
+
+    ,output logic               imem_req_val
+    ,output logic   [XLEN-1:0]  imem_req_addr
+    ,input  logic               imem_req_rdy
+
+    ,input  logic               imem_resp_val
+    ,input  logic   [XLEN-1:0]  imem_resp_data
+
+    ,output logic               dmem_req_val
+    ,output logic               dmem_req_wen
+    ,output logic   [XLEN-1:0]  dmem_req_addr
+    ,output logic   [XLEN-1:0]  dmem_req_wdata
+    ,input  logic               dmem_req_rdy
+
+    ,input  logic               dmem_resp_val
+    ,input  logic   [XLEN-1:0]  dmem_resp_rdata
+
+    ,output logic               retire_val
+    ,output logic   [XLEN-1:0]  retire_pc
+    ,output logic   [XLEN-1:0]  retire_inst
+    ,output logic               retire_rd_wen
+    ,output logic   [REG_ADDR_W-1:0]    retire_rd_addr
+    ,output logic   [XLEN-1:0]  retire_rd_data
+
+    ,output logic               perf_stall_data
+    ,output logic               perf_stall_ctrl
+    ,output logic               perf_stall_mem
+);
+
+    pipeline #(
+         .FORWARDING    (FORWARDING )
+    ) core (
+         .clk   (clk    )
+        ,.rst   (rst    )
+
+        ,.rst_pc            (rst_pc             )
+
+        ,.imem_req_val      (imem_req_val       )
+        ,.imem_req_addr     (imem_req_addr      )
+        ,.imem_req_rdy      (imem_req_rdy       )
+
+        ,.imem_resp_val     (imem_resp_val      )
+        ,.imem_resp_data    (imem_resp_data     )
+
+        ,.dmem_req_val      (dmem_req_val       )
+        ,.dmem_req_wen      (dmem_req_wen       )
+        ,.dmem_req_addr     (dmem_req_addr      )
+        ,.dmem_req_wdata    (dmem_req_wdata     )
+        ,.dmem_req_rdy      (dmem_req_rdy       )
+
+        ,.dmem_resp_val     (dmem_resp_val      )
+        ,.dmem_resp_rdata   (dmem_resp_rdata    )
+
+        ,.retire_val        (retire_val         )
+        ,.retire_pc         (retire_pc          )
+        ,.retire_inst       (retire_inst        )
+        ,.retire_rd_wen     (retire_rd_wen      )
+        ,.retire_rd_addr    (retire_rd_addr     )
+        ,.retire_rd_data    (retire_rd_data     )
+
+        ,.perf_stall_data   (perf_stall_data    )
+        ,.perf_stall_ctrl   (perf_stall_ctrl    )
+        ,.perf_stall_mem    (perf_stall_mem     )
+    );
+
+    initial begin
+        // +quiet leaves this out, for runs whose output is parsed or compared
+        if (!$test$plusargs("quiet")) begin
+            $display("[%0t] Model running...\n", $time);
+        end
+    end
+endmodule
@@ -0,0 +1,607 @@
+// For std::unique_ptr
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Include common routines
+#include <verilated.h>
+
+// Include model header, generated from Verilating "top.v"
+#include "Vpipeline_top.h"
+
+// Edge-driven clock
+#include "sim_clock.h"
+// Harness plusargs
+#include "sim_args.h"
+// Seeded stimulus
+#include "sim_rand.h"
+// Waveform tracing
+#include "sim_trace.h"
+// Hang detection
+#include "sim_watchdog.h"
+// Program images in host memory
+#include "sim_image.h"
+// Encodings of the five instructions
+#include "pipeline_isa.h"
+// Reference model to check the retirements against
+#include "pipeline_ref.h"
+
+// Whether the model forwards operands, the same as its FORWARDING parameter.
+// The Makefile passes both
+#ifndef FORWARDING
+#define FORWARDING 1
+#endif
+
+#define CLOCK_HALF_CYCLE_NS 5
+#define CLOCK_CYCLE_NS (CLOCK_HALF_CYCLE_NS * 2)
+
+// Bytes of memory, change with +mem_size. Only the pages the program touches
+// take up any host memory
+#define MEM_DEFAULT_SIZE (16ULL << 20)
+// A store here ends the run, unless the ELF image has a tohost symbol. It's
+// -16(x0), so any program can reach it
+#define TOHOST_DEFAULT 0xfffffff0
+// Iterations of the built-in program's loop, for +demo=N with no count
+#define DEMO_DEFAULT_ITERATIONS (1ULL << 20)
+// Instructions in the loop of a +random program, and the most there can be,
+// so the branch back to the top still reaches
+#define RANDOM_DEFAULT_LENGTH 512
+#define RANDOM_MAX_LENGTH 1000
+// Times around the loop, at most what addi can load
+#define RANDOM_DEFAULT_ITERATIONS 2047
+// Cycles the pipeline has to retire the tohost store in after it reaches
+// memory, when the reference model checks it
+#define COSIM_DRAIN_CYCLES 64
+// Cycles without an instruction retiring before the watchdog gives up
+#define WATCHDOG_DEFAULT_CYCLES 4096
+
+static void init_context(const std::unique_ptr<VerilatedContext> &contextp,
+                         int argc,
+                         char ** argv) {
+    // Set debug level, 0 is off, 9 is highest presently used
+    // May be overridden by commandArgs argument parsing
+    contextp->debug(0);
+
+    // Randomization reset policy
+    // May be overridden by commandArgs argument parsing
+    contextp->randReset(2);
+
+    // Random initial values depend on +seed=N, so each seed of a regression
+    // starts from a different power-on state
+    // May be overridden by commandArgs argument parsing, with +verilator+seed+N
+    const SimArgs args{argc, argv};
+    if (args.flag("seed")) {
+        contextp->randSeed(sim_verilator_seed(args.u64("seed", 0)));
+    }
+
+    // Verilator must compute traced signals
+    contextp->traceEverOn(true);
+
+    // Pass arguments so Verilated code can see them, e.g. $value$plusargs
+    // This needs to be called before you create any model
+    contextp->commandArgs(argc, argv);
+
+}
+
+/*******************************************************************************
+ * Watchdog, see sim_watchdog.h. Ends the run with a dump of the ports and exit
+ * code SIM_WATCHDOG_EXIT when no instruction has retired for +watchdog=N
+ * cycles, +watchdog=0 to turn it off. +watchdog_trace=M writes the last M
+ * cycles to logs/watchdog_0.vcd as well
+ ******************************************************************************/
+static const std::vector<FlightSignal> watch_signals = {
+    {"clk", 1},
+    {"rst", 1},
+    {"imem_req_val", 1},
+    {"imem_req_addr", 32},
+    {"imem_req_rdy", 1},
+    {"imem_resp_val", 1},
+    {"imem_resp_data", 32},
+    {"dmem_req_val", 1},
+    {"dmem_req_wen", 1},
+    {"dmem_req_addr", 32},
+    {"dmem_req_wdata", 32},
+    {"dmem_req_rdy", 1},
+    {"dmem_resp_val", 1},
+    {"dmem_resp_rdata", 32},
+    {"retire_val", 1},
+    {"retire_pc", 32},
+    {"retire_inst", 32},
+    {"retire_rd_wen", 1},
+    {"retire_rd_addr", 5},
+    {"retire_rd_data", 32},
+    {"perf_stall_data", 1},
+    {"perf_stall_ctrl", 1},
+    {"perf_stall_mem", 1}
+};
+
+static void watch_sample(const Vpipeline_top *top, uint64_t *values) {
+    values[0] = top->clk;
+    values[1] = top->rst;
+    values[2] = top->imem_req_val;
+    values[3] = top->imem_req_addr;
+    values[4] = top->imem_req_rdy;
+    values[5] = top->imem_resp_val;
+    values[6] = top->imem_resp_data;
+    values[7] = top->dmem_req_val;
+    values[8] = top->dmem_req_wen;
+    values[9] = top->dmem_req_addr;
+    values[10] = top->dmem_req_wdata;
+    values[11] = top->dmem_req_rdy;
+    values[12] = top->dmem_resp_val;
+    values[13] = top->dmem_resp_rdata;
+    values[14] = top->retire_val;
+    values[15] = top->retire_pc;
+    values[16] = top->retire_inst;
+    values[17] = top->retire_rd_wen;
+    values[18] = top->retire_rd_addr;
+    values[19] = top->retire_rd_data;
+    values[20] = top->perf_stall_data;
+    values[21] = top->perf_stall_ctrl;
+    values[22] = top->perf_stall_mem;
+}
+
+// Retirement has no rdy, an instruction leaving writeback is the handshake
+static bool watch_retire_val(const Vpipeline_top *top) { return top->retire_val; }
+static bool watch_retire_rdy(const Vpipeline_top *top) { (void)top; return true; }
+
+static const std::vector<WatchPort<Vpipeline_top>> watch_ports = {
+    {"retire", watch_retire_val, watch_retire_rdy}
+};
+
+/*******************************************************************************
+ * Memory. Both memories are served out of the same SimImage: the requests the
+ * pipeline makes up to a rising edge are answered right after it, with a
+ * pointer into the image and no copies
+ ******************************************************************************/
+struct PipelineConfig {
+    uint32_t tohost;
+    // Cycles to give up after, 0 for no limit
+    uint64_t max_cycles;
+    // Percent of cycles each memory holds req_rdy low
+    uint64_t imem_stall;
+    uint64_t dmem_stall;
+    uint64_t seed;
+};
+
+struct PipelineRun {
+    uint64_t cycles = 0;
+    uint64_t retired = 0;
+    uint64_t fetches = 0;
+    uint64_t loads = 0;
+    uint64_t stores = 0;
+    // Cycles lost to each cause, from the perf_stall_* outputs
+    uint64_t stall_data = 0;
+    uint64_t stall_ctrl = 0;
+    uint64_t stall_mem = 0;
+    // Cycles a memory held off a request, from the harness's side
+    uint64_t imem_held = 0;
+    uint64_t dmem_held = 0;
+    double wall_seconds = 0.0;
+    // Set when the program stores to tohost
+    bool halted = false;
+    uint32_t tohost = 0;
+    // Set on an access outside of memory or not aligned to a word
+    bool bad_access = false;
+    // Set when a retirement differs from the reference model
+    bool diverged = false;
+    uint64_t halt_cycle = 0;
+};
+
+static bool check_access(const std::unique_ptr<VerilatedContext> &contextp,
+                         const SimImage &mem, uint32_t addr, const char *what) {
+    if (((addr & 0x3) != 0) || !mem.in_range(addr, 4)) {
+        VL_PRINTF("[%" VL_PRI64 "d] ERROR: %s of %08x is outside of the %" VL_PRI64 "u byte \
+memory or not word aligned\n", contextp->time(), what, addr, mem.size());
+        return false;
+    }
+    return true;
+}
+
+// Runs until the program stores to tohost, makes a bad access or runs out of
+// cycles. With cosim, every retirement is checked against the reference model,
+// the run stops at the first one that differs, and a store to tohost ends it
+// only once the store has retired. Must be called with the clock low, after
+// reset
+static void run_program(const std::unique_ptr<VerilatedContext> &contextp,
+                        SimClock<Vpipeline_top> &sim, SimImage &mem, PipelineCosim *cosim,
+                        const PipelineConfig &config, PipelineRun &run) {
+    Vpipeline_top *top = sim.top();
+    SimRand rand{config.seed};
+    auto start = std::chrono::steady_clock::now();
+
+    while (!run.bad_access && !run.diverged
+            && ((config.max_cycles == 0) || (run.cycles < config.max_cycles))) {
+        if (run.halted && ((cosim == nullptr) || cosim->finished()
+                           || (run.cycles - run.halt_cycle >= COSIM_DRAIN_CYCLES))) {
+            break;
+        }
+
+        // What the rising edge takes, as the falling edge left it
+        bool fetch = top->imem_req_val && top->imem_req_rdy;
+        uint32_t fetch_addr = top->imem_req_addr;
+        bool access = top->dmem_req_val && top->dmem_req_rdy;
+        bool write = top->dmem_req_wen;
+        uint32_t addr = top->dmem_req_addr;
+        uint32_t wdata = top->dmem_req_wdata;
+        run.stall_data += top->perf_stall_data;
+        run.stall_ctrl += top->perf_stall_ctrl;
+        run.stall_mem += top->perf_stall_mem;
+        run.imem_held += top->imem_req_val && !top->imem_req_rdy;
+        run.dmem_held += top->dmem_req_val && !top->dmem_req_rdy;
+        // A store reaches memory before it retires, or in the same cycle at
+        // the latest, so it's queued first
+        if ((cosim != nullptr) && access && write) {
+            cosim->store(addr, wdata);
+        }
+        if (top->retire_val) {
+            run.retired++;
+            if ((cosim != nullptr) && !cosim->retire(run.cycles, top->retire_pc,
+                    top->retire_inst, top->retire_rd_wen, top->retire_rd_addr,
+                    top->retire_rd_data)) {
+                run.diverged = true;
+                break;
+            }
+        }
+
+        sim.half_cycle();
+        run.cycles++;
+
+        top->imem_resp_val = fetch;
+        if (fetch) {
+            run.fetches++;
+            if (!check_access(contextp, mem, fetch_addr, "fetch")) {
+                run.bad_access = true;
+                break;
+            }
+            top->imem_resp_data = *mem.word(fetch_addr);
+        }
+
+        top->dmem_resp_val = access;
+        if (access) {
+            if (write && (addr == config.tohost)) {
+                if (!run.halted) {
+                    run.halt_cycle = run.cycles;
+                }
+                run.halted = true;
+                run.tohost = wdata;
+            }
+            else if (!check_access(contextp, mem, addr, write ? "store" : "load")) {
+                run.bad_access = true;
+                break;
+            }
+            else if (write) {
+                run.stores++;
+                *mem.word(addr) = wdata;
+            }
+            else {
+                run.loads++;
+                top->dmem_resp_rdata = *mem.word(addr);
+            }
+        }
+
+        // Whether the memories take a request on the next edge
+        top->imem_req_rdy = (config.imem_stall == 0) || !rand.chance(config.imem_stall, 100);
+        top->dmem_req_rdy = (config.dmem_stall == 0) || !rand.chance(config.dmem_stall, 100);
+
+        sim.half_cycle();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    run.wall_seconds = elapsed.count();
+}
+
+// CPI, and how much of it each cause of stalls adds. Whatever the counters
+// don't cover is filling and draining the pipeline
+static void report_cpi(const PipelineRun &run) {
+    double retired = (run.retired == 0) ? 1.0 : (double)run.retired;
+    uint64_t stalls = run.stall_data + run.stall_ctrl + run.stall_mem;
+    uint64_t accounted = run.retired + stalls;
+    uint64_t other = (run.cycles > accounted) ? run.cycles - accounted : 0;
+    VL_PRINTF("CPI %.3f with forwarding %s\n", (double)run.cycles / retired,
+            FORWARDING ? "on" : "off");
+    VL_PRINTF("  %-16s %12" VL_PRI64 "u cycles, %.3f CPI\n", "data hazards", run.stall_data,
+            (double)run.stall_data / retired);
+    VL_PRINTF("  %-16s %12" VL_PRI64 "u cycles, %.3f CPI\n", "control hazards", run.stall_ctrl,
+            (double)run.stall_ctrl / retired);
+    VL_PRINTF("  %-16s %12" VL_PRI64 "u cycles, %.3f CPI (imem held off %" VL_PRI64 "u, dmem \
+%" VL_PRI64 "u)\n", "memory", run.stall_mem, (double)run.stall_mem / retired, run.imem_held,
+            run.dmem_held);
+    VL_PRINTF("  %-16s %12" VL_PRI64 "u cycles, %.3f CPI\n", "other", other,
+            (double)other / retired);
+    if (run.cycles < accounted) {
+        VL_PRINTF("WARNING: %" VL_PRI64 "u stall cycles and %" VL_PRI64 "u retirements in \
+%" VL_PRI64 "u cycles, is more than one perf_stall_* high at once?\n", stalls, run.retired,
+                run.cycles);
+    }
+}
+
+/*******************************************************************************
+ * Built-in program, for +demo or when there's no +image. Adds up 1 to N with a
+ * store and a load of the running sum in the loop, checks the load and the
+ * total with bne, and stores 1 to tohost if they're right, 3 if not
+ ******************************************************************************/
+#define DEMO_DATA 0x400
+#define DEMO_N (DEMO_DATA + 0)
+#define DEMO_SUM (DEMO_DATA + 4)
+#define DEMO_BUF (DEMO_DATA + 8)
+
+static void build_demo(SimImage &mem, uint32_t iterations) {
+    const uint32_t program[] = {
+        rv_lw(1, 0, DEMO_N),        // 0x00  x1 = N
+        rv_lw(6, 0, DEMO_SUM),      // 0x04  x6 = what the sum should come to
+        rv_addi(2, 0, 0),           // 0x08  x2 = sum
+        rv_addi(3, 0, 0),           // 0x0c  x3 = i
+        rv_addi(3, 3, 1),           // 0x10  loop: i += 1
+        rv_add(2, 2, 3),            // 0x14  sum += i
+        rv_sw(2, 0, DEMO_BUF),      // 0x18  store the sum
+        rv_lw(4, 0, DEMO_BUF),      // 0x1c  and load it back
+        rv_bne(4, 2, 0x38 - 0x20),  // 0x20  fail if the load missed the store
+        rv_bne(3, 1, 0x10 - 0x24),  // 0x24  until i == N
+        rv_bne(2, 6, 0x38 - 0x28),  // 0x28  fail if the sum is wrong
+        rv_addi(7, 0, 1),           // 0x2c  pass
+        rv_sw(7, 0, -16),           // 0x30
+        rv_bne(7, 0, 0),            // 0x34  spin
+        rv_addi(7, 0, 3),           // 0x38  fail
+        rv_sw(7, 0, -16),           // 0x3c
+        rv_bne(7, 0, 0)             // 0x40  spin
+    };
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+        mem.write32(4 * i, program[i]);
+    }
+    uint64_t n = iterations;
+    mem.write32(DEMO_N, iterations);
+    mem.write32(DEMO_SUM, (uint32_t)(n * (n + 1) / 2));
+}
+
+/*******************************************************************************
+ * Random programs, for +random=N. A loop of N random instructions, run
+ * +random_iters times, with loads and stores to a data area around
+ * RANDOM_DATA and branches that only skip forward within the loop. Every
+ * instruction the pipeline retires is checked against the reference model,
+ * which is what decides whether the run passes, so the program stores 1 to
+ * tohost at the end regardless.
+ *
+ *   x1 - x28  random values
+ *   x29       iterations
+ *   x30       RANDOM_DATA, the base of the loads and stores
+ *   x31       loop count
+ ******************************************************************************/
+#define RANDOM_DATA 0x10000
+#define RANDOM_REGS 28
+
+static bool build_random(SimImage &mem, uint64_t seed, uint32_t length, uint32_t iterations) {
+    if (!mem.in_range(RANDOM_DATA + 2048, 4)) {
+        VL_PRINTF("+random needs at least %d bytes of memory\n", RANDOM_DATA + 2048);
+        return false;
+    }
+    // A stream of its own, so the program doesn't change with the backpressure
+    SimRand rand{seed, 1};
+    std::vector<uint32_t> program;
+
+    // x30 = 0x400 << 6
+    program.push_back(rv_addi(30, 0, 0x400));
+    for (int i = 0; i < 6; i++) {
+        program.push_back(rv_add(30, 30, 30));
+    }
+    program.push_back(rv_addi(29, 0, (int32_t)iterations));
+    program.push_back(rv_addi(31, 0, 0));
+    for (unsigned r = 1; r <= RANDOM_REGS; r++) {
+        program.push_back(rv_addi(r, 0, (int32_t)rand.bits(12)));
+    }
+
+    size_t loop = program.size();
+    for (uint32_t i = 0; i < length; i++) {
+        unsigned rd = 1 + (unsigned)rand.below(RANDOM_REGS);
+        unsigned rs1 = (unsigned)rand.below(RANDOM_REGS + 1);
+        unsigned rs2 = (unsigned)rand.below(RANDOM_REGS + 1);
+        // Word aligned, from -2048 to 2044
+        int32_t offset = (int32_t)rand.below(1024) * 4 - 2048;
+        uint64_t kind = rand.below(100);
+        if (kind < 30) {
+            program.push_back(rv_add(rd, rs1, rs2));
+        }
+        else if (kind < 60) {
+            program.push_back(rv_addi(rd, rs1, (int32_t)rand.bits(12)));
+        }
+        else if (kind < 75) {
+            program.push_back(rv_lw(rd, 30, offset));
+        }
+        else if (kind < 90) {
+            program.push_back(rv_sw(rs2, 30, offset));
+        }
+        else {
+            // Skips up to 7 instructions, at most to the end of the loop
+            uint64_t skip = 1 + rand.below((length - i < 8) ? length - i : 8);
+            program.push_back(rv_bne(rs1, rs2, (int32_t)(4 * skip)));
+        }
+    }
+    program.push_back(rv_addi(31, 31, 1));
+    program.push_back(rv_bne(31, 29, -4 * (int32_t)(program.size() - loop)));
+    program.push_back(rv_addi(1, 0, 1));
+    program.push_back(rv_sw(1, 0, -16));
+    program.push_back(rv_bne(1, 0, 0));
+
+    for (size_t i = 0; i < program.size(); i++) {
+        mem.write32(4 * (uint32_t)i, program[i]);
+    }
+    for (uint32_t addr = RANDOM_DATA - 2048; addr < RANDOM_DATA + 2048; addr += 4) {
+        mem.write32(addr, (uint32_t)rand.next());
+    }
+    return true;
+}
+
+// Loads the program the plusargs ask for into mem: +image=<raw binary or
+// ELF>, +random=N, or the built-in one. Updates tohost from the image
+static bool load_program(const SimArgs &args, SimImage &mem, uint32_t &tohost, bool verbose) {
+    if (!mem.ok()) {
+        VL_PRINTF("Can't map %" VL_PRI64 "u bytes of memory\n", mem.size());
+        return false;
+    }
+    const char *image = args.str("image", nullptr);
+    if (image != nullptr) {
+        if (!mem.load(image)) {
+            return false;
+        }
+        mem.tohost(tohost);
+        if (verbose) {
+            VL_PRINTF("Loaded %s, entry %08x, tohost %08x\n", image, mem.entry(), tohost);
+        }
+    }
+    else if (args.flag("random")) {
+        uint64_t length = args.u64("random", RANDOM_DEFAULT_LENGTH);
+        uint64_t iterations = args.u64("random_iters", RANDOM_DEFAULT_ITERATIONS);
+        length = (length > RANDOM_MAX_LENGTH) ? RANDOM_MAX_LENGTH : length;
+        iterations = (iterations > RANDOM_DEFAULT_ITERATIONS) ? RANDOM_DEFAULT_ITERATIONS
+                   : (iterations == 0) ? 1 : iterations;
+        if (!build_random(mem, args.u64("seed", 0), (uint32_t)length, (uint32_t)iterations)) {
+            return false;
+        }
+        if (verbose) {
+            VL_PRINTF("Running a random program of %" VL_PRI64 "u instructions %" VL_PRI64 "u \
+times\n", length, iterations);
+        }
+    }
+    else {
+        uint64_t iterations = args.u64("demo", DEMO_DEFAULT_ITERATIONS);
+        build_demo(mem, (uint32_t)iterations);
+        if (verbose) {
+            VL_PRINTF("Running the built-in program for %" VL_PRI64 "u iterations\n",
+                    iterations);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv, char** env) {
+    // Prevent unused variable warnings
+    if (false && argc && argv && env) {}
+
+    // Create logs/ directory in case we have traces to put under it
+    Verilated::mkdir("logs");
+
+    // Using unique_ptr is similar to
+    // "VerilatedContext* contextp = new VerilatedContext" then deleting at end.
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+
+    init_context(contextp, argc, argv);
+
+    const SimArgs args{argc, argv};
+
+    PipelineConfig config;
+    config.tohost = TOHOST_DEFAULT;
+    SimImage mem{args.u64("mem_size", MEM_DEFAULT_SIZE)};
+    if (!load_program(args, mem, config.tohost, true)) {
+        return 1;
+    }
+    config.tohost = (uint32_t)args.u64("tohost", config.tohost);
+    config.max_cycles = args.u64("max_cycles", 0);
+    config.imem_stall = args.u64("imem_stall", 0);
+    config.dmem_stall = args.u64("dmem_stall", 0);
+    config.seed = args.u64("seed", 0);
+
+    // Construct the Verilated model, from Vpipeline_top.h generated from
+    // Verilating "pipeline_top".
+    // "TOP" will be the hierarchical name of the module.
+    const std::unique_ptr<Vpipeline_top> top{new Vpipeline_top{contextp.get(), "TOP"}};
+
+    // Only evaluates the model on clock edges
+    SimClock<Vpipeline_top> sim{contextp.get(), top.get(), CLOCK_HALF_CYCLE_NS};
+
+    // Waveforms with +trace, see sim_trace.h for the options
+    SimTrace<Vpipeline_top> trace{contextp.get(), top.get(), args};
+    trace.attach(sim);
+
+    std::unique_ptr<SimWatchdog<Vpipeline_top>> watchdog;
+    uint64_t watchdog_cycles = args.u64("watchdog", WATCHDOG_DEFAULT_CYCLES);
+    if (watchdog_cycles != 0) {
+        watchdog.reset(new SimWatchdog<Vpipeline_top>{sim, watch_ports, watch_signals,
+                watch_sample, watchdog_cycles, args.u64("watchdog_trace", 0),
+                "logs/watchdog"});
+        watchdog->set_hang_hook([&]() {
+            trace.close();
+        });
+    }
+
+    // Set some initial data values
+    top->rst_pc = mem.entry();
+    top->imem_req_rdy = 1;
+    top->imem_resp_val = 0;
+    top->imem_resp_data = 0;
+    top->dmem_req_rdy = 1;
+    top->dmem_resp_val = 0;
+    top->dmem_resp_rdata = 0;
+
+    top->clk = 0;
+    top->rst = 1;
+
+    sim.cycle(); // Kick the simulation
+    sim.cycle();
+
+    top->rst = 0;
+    sim.eval();
+
+    // Lockstep co-simulation with the reference model, which gets a copy of
+    // the program in memory of its own. +cosim=0 to run without it
+    std::unique_ptr<SimImage> ref_mem;
+    std::unique_ptr<PipelineCosim> cosim;
+    if (args.u64("cosim", 1) != 0) {
+        uint32_t ignored;
+        ref_mem.reset(new SimImage{mem.size()});
+        if (!load_program(args, *ref_mem, ignored, false)) {
+            return 1;
+        }
+        cosim.reset(new PipelineCosim{*ref_mem, mem.entry(), config.tohost});
+    }
+
+    PipelineRun run;
+    run_program(contextp, sim, mem, cosim.get(), config, run);
+
+    double ipc = (run.cycles == 0) ? 0.0 : (double)run.retired / (double)run.cycles;
+    double seconds = (run.wall_seconds > 0.0) ? run.wall_seconds : 1e-9;
+    VL_PRINTF("Retired %" VL_PRI64 "u instructions in %" VL_PRI64 "u cycles, IPC %.3f\n",
+            run.retired, run.cycles, ipc);
+    VL_PRINTF("  %" VL_PRI64 "u fetches, %" VL_PRI64 "u loads, %" VL_PRI64 "u stores\n",
+            run.fetches, run.loads, run.stores);
+    VL_PRINTF("  %.3f s, %.2f simulated MIPS, %.0f cycles/s\n", run.wall_seconds,
+            (double)run.retired / seconds / 1e6, (double)run.cycles / seconds);
+    report_cpi(run);
+
+    if (cosim) {
+        if (run.halted && !run.diverged && !cosim->finished()) {
+            VL_PRINTF("ERROR: the store to tohost didn't retire within %d cycles\n",
+                    COSIM_DRAIN_CYCLES);
+            run.diverged = true;
+        }
+        if (!cosim->check_done(run.cycles)) {
+            run.diverged = true;
+        }
+        VL_PRINTF("Co-simulation: %" VL_PRI64 "u instructions and %" VL_PRI64 "u stores matched \
+the reference model%s\n", cosim->retired(), cosim->stores_checked(),
+                run.diverged ? " before diverging" : "");
+    }
+
+    bool passed = false;
+    if (run.diverged) {
+        VL_PRINTF("FAILED\n");
+    }
+    else if (run.halted) {
+        // riscv-tests convention: 1 is a pass, anything else is a failure
+        // with the test number shifted up by one
+        passed = run.tohost == 1;
+        VL_PRINTF("tohost = %08x, %s\n", run.tohost, passed ? "PASSED" : "FAILED");
+    }
+    else if (!run.bad_access) {
+        VL_PRINTF("ERROR: no store to tohost after %" VL_PRI64 "u cycles\n", run.cycles);
+    }
+
+    // Final model cleanup
+    top->final();
+
+    // Flush the rest of the trace
+    trace.close();
+
+    return passed ? 0 : 1;
+}